@@ -2,16 +2,30 @@
 
 #include <any>
 #include <map>
+#include <set>
 #include <tuple>
+#include <bitset>
 #include <string>
+#include <vector>
 #include <memory>
+#include <limits>
 #include <variant>
+#include <cstring>
+#include <cstdint>
 #include <optional>
+#include <iterator>
 #include <typeinfo>
+#include <algorithm>
 #include <exception>
+#include <stdexcept>
 #include <functional>
+#include <string_view>
 #include <type_traits>
 
+#if __cplusplus > 201703L
+#include <bit>
+#endif
+
 namespace parsec {
 #if __cplusplus > 201703L
 
@@ -182,21 +196,89 @@ struct Placeholder
     Placeholder(const T &&) {}
 };
 
-template<typename Result>
+template<typename Result, typename Input = std::string>
 class ParsecComponent;
 
-template<typename Result>
+template<typename Result, typename Input = std::string>
 class Parsec;
 
 inline
-std::map<std::tuple<void *, const std::string *, size_t>,
+std::map<std::tuple<void *, const void *, size_t>,
     std::pair<void *, size_t>>
 theMemory;
 
-template<typename Func>
+using TraceKey = std::tuple<const void *, const void *, size_t>;
+
+// State shared by both passes of Parsec::deferred, keyed by the address
+// of a node, the input and an index
+struct Trace
+{
+    // Left alternatives that failed while recognizing, so that replaying
+    // the successful derivation skips them without running their actions
+    std::set<TraceKey> failed;
+
+    // Values that drive later parsing with the index after them, parsed
+    // once and reused by the replay, which also keeps alive the nodes
+    // built while parsing so their addresses stay unique in both passes
+    std::map<TraceKey, std::pair<std::shared_ptr<void>, std::size_t>> values;
+};
+
+inline
+Trace *theTrace = nullptr;
+
+inline
+bool theReplaying = false;
+
+struct TraceGuard
+{
+    TraceGuard(Trace *trace)
+      : trace_(theTrace), replaying_(theReplaying)
+    {
+        theTrace = trace;
+        theReplaying = false;
+    }
+
+    ~TraceGuard()
+    {
+        theTrace = trace_;
+        theReplaying = replaying_;
+    }
+
+  private:
+    Trace *trace_;
+    bool replaying_;
+};
+
+// Gives make(str, index), computed only once for owner at index
+// while a Trace is active
+template<typename Func, typename Input>
+inline auto
+traced_value(const void *owner, const Func &make,
+    const Input &str, std::size_t &index)
+{
+    using Value = decltype(make(str, index));
+    if (!theTrace)
+    {
+        return make(str, index);
+    }
+
+    auto key = TraceKey(owner, &str, index);
+    auto it = theTrace->values.find(key);
+    if (it != theTrace->values.end())
+    {
+        index = it->second.second;
+        return *std::static_pointer_cast<Value>(it->second.first);
+    }
+    auto value = make(str, index);
+    theTrace->values.emplace(key,
+        std::make_pair(std::make_shared<Value>(value), index));
+    return value;
+}
+
+template<typename Func, typename Input>
 inline auto
 get_result(const Func &func,
-    const std::string &str, std::size_t &index)
+    const Input &str, std::size_t &index)
 {
     auto key = std::make_tuple<void *>((void *)&func, &str, index);
     if (theMemory.count(key))
@@ -217,34 +299,64 @@ get_result(const Func &func,
     }
 }
 
-template<typename Func, typename T>
+template<typename Func, typename Input, typename T>
 inline void
 put_in_mem(const Func &func,
-    const std::string &str, size_t index,
+    const Input &str, size_t index,
     T &&value, size_t target)
 {
     theMemory[std::make_tuple<void *>((void *)&func, &str, index)]
         = std::make_pair<void *>(new T(std::move(value)), target);
 }
 
-template<typename Result, typename Func1, typename Func2>
+// Calls func with value, or with its elements if it is a Tuple
+template<typename Func, typename T>
+inline auto
+apply_value(const Func &func, T &&value)
+{
+    if constexpr (is_tuple_v<std::decay_t<T>>)
+    {
+        return std::apply(func, std::forward<T>(value));
+    }
+    else
+    {
+        return func(std::forward<T>(value));
+    }
+}
+
+// Flattens two values into one Tuple, as product_t does for their types
+template<typename T1, typename T2>
+inline auto
+concat_values(T1 lv, T2 rv)
+{
+    if constexpr (is_tuple_v<T1> and is_tuple_v<T2>)
+    {
+        return std::tuple_cat(std::move(lv), std::move(rv));
+    }
+    else if constexpr (is_tuple_v<T1>)
+    {
+        return std::tuple_cat(std::move(lv), std::make_tuple(std::move(rv)));
+    }
+    else if constexpr (is_tuple_v<T2>)
+    {
+        return std::tuple_cat(std::make_tuple(std::move(lv)), std::move(rv));
+    }
+    else
+    {
+        return std::make_tuple(std::move(lv), std::move(rv));
+    }
+}
+
+template<typename Result, typename Func1, typename Func2, typename Input>
 inline std::optional<Result>
 callback_template(const Func1 &exec, const Func2 &callback,
-    const std::string &str, std::size_t &index)
+    const Input &str, std::size_t &index)
 {
     auto anchor = index;
     auto result = get_result(exec, str, index);
     if (result)
     {
-        auto v = std::move(result).value();
-        if constexpr (is_tuple_v<decltype(v)>)
-        {
-            return std::apply(callback, std::move(v));
-        }
-        else
-        {
-            return callback(std::move(v));
-        }
+        return apply_value(callback, std::move(result).value());
     }
     else
     {
@@ -253,37 +365,39 @@ callback_template(const Func1 &exec, const Func2 &callback,
     }
 }
 
-template<typename Result, typename Func1, typename Func2>
+template<typename Result, typename Func1, typename Func2, typename Input>
 inline std::optional<Result>
 alternate_template(const Func1 &lexec, const Func2 &rexec,
-    const std::string &str, std::size_t &index)
+    const Input &str, std::size_t &index)
 {
     auto anchor = index;
-    auto lr = get_result(lexec, str, index);
-    if (lr)
+    if (!theReplaying
+        or !theTrace->failed.count(TraceKey(&lexec, &str, index)))
+    {
+        auto lr = get_result(lexec, str, index);
+        if (lr)
+        {
+            return lr;
+        }
+        index = anchor;
+    }
+
+    auto rr = get_result(rexec, str, index);
+    if (rr)
     {
-        return lr;
+        return rr;
     }
     else
     {
         index = anchor;
-        auto rr = get_result(rexec, str, index);
-        if (rr)
-        {
-            return rr;
-        }
-        else
-        {
-            index = anchor;
-            return {};
-        }
+        return {};
     }
 }
 
-template<typename Result, typename Func1, typename Func2>
+template<typename Result, typename Func1, typename Func2, typename Input>
 inline std::optional<Result>
 connect_template(const Func1 &lexec, const Func2 &rexec,
-    const std::string &str, std::size_t &index)
+    const Input &str, std::size_t &index)
 {
     auto anchor = index;
     auto lr = get_result(lexec, str, index);
@@ -293,24 +407,7 @@ connect_template(const Func1 &lexec, const Func2 &rexec,
         auto rr = get_result(rexec, str, index);
         if (rr)
         {
-            auto lv = std::move(lr).value();
-            auto rv = std::move(rr).value();
-            if constexpr (is_tuple_v<decltype(lv)> and is_tuple_v<decltype(rv)>)
-            {
-                return std::tuple_cat(std::move(lv), std::move(rv));
-            }
-            else if constexpr (is_tuple_v<decltype(lv)>)
-            {
-                return std::tuple_cat(std::move(lv), std::make_tuple(std::move(rv)));
-            }
-            else if constexpr (is_tuple_v<decltype(rv)>)
-            {
-                return std::tuple_cat(std::make_tuple(std::move(lv)), std::move(rv));
-            }
-            else
-            {
-                return std::make_tuple(std::move(lv), std::move(rv));
-            };
+            return concat_values(std::move(lr).value(), std::move(rr).value());
         }
         else
         {
@@ -326,112 +423,210 @@ connect_template(const Func1 &lexec, const Func2 &rexec,
     }
 }
 
+template<typename Node1, typename Node2, typename Input>
+inline bool
+alternate_recognize(const Node1 &lnode, const Node2 &rnode,
+    const Input &str, std::size_t &index)
+{
+    auto anchor = index;
+    if (lnode.recognize(str, index))
+    {
+        return true;
+    }
+    index = anchor;
+    if (theTrace)
+    {
+        theTrace->failed.emplace(&lnode.exec, &str, anchor);
+    }
+
+    if (rnode.recognize(str, index))
+    {
+        return true;
+    }
+    else
+    {
+        index = anchor;
+        return false;
+    }
+}
+
+template<typename Node1, typename Node2, typename Input>
+inline bool
+connect_recognize(const Node1 &lnode, const Node2 &rnode,
+    const Input &str, std::size_t &index)
+{
+    auto anchor = index;
+    if (lnode.recognize(str, index) and rnode.recognize(str, index))
+    {
+        return true;
+    }
+    else
+    {
+        index = anchor;
+        return false;
+    }
+}
+
 // Result must be a single type, Tuple or Variant
-template<typename Result>
+template<typename Result, typename Input>
 class ParsecComponent
 {
   public:
     using OptResult = std::optional<Result>;
-    using ExecFunc = std::function<OptResult(const std::string &, std::size_t &)>;
+    using ExecFunc = std::function<OptResult(const Input &, std::size_t &)>;
+    using RecogFunc = std::function<bool(const Input &, std::size_t &)>;
 
+    // Recognizing runs no action, leaves without one fall back to exec
+    struct Node
+    {
+        ExecFunc exec;
+        RecogFunc recog;
+
+        bool
+        recognize(const Input &str, std::size_t &index) const
+        {
+            if (recog)
+            {
+                return recog(str, index);
+            }
+            auto anchor = index;
+            if (exec(str, index))
+            {
+                return true;
+            }
+            index = anchor;
+            return false;
+        }
+    };
+
+    // Nodes are shared, copying or reusing a component never copies its tree
     ParsecComponent() = default;
-    ParsecComponent(ParsecComponent &&component)
-      : exec_(std::move(component.exec_)) {}
-    ParsecComponent(ExecFunc exec)
-      : exec_(std::move(exec)) {}
+    ParsecComponent(ExecFunc exec, RecogFunc recog = nullptr)
+      : node_(std::make_shared<const Node>(Node{std::move(exec), std::move(recog)})) {}
 
     OptResult
-    operator()(const std::string &str, std::size_t &index) const
+    operator()(const Input &str, std::size_t &index) const
+    {
+        return node_->exec(str, index);
+    }
+
+    bool
+    recognize(const Input &str, std::size_t &index) const
     {
-        return exec_(str, index);
+        return node_->recognize(str, index);
     }
 
     template<typename Func,
         typename NewResult = typename lambda_traits<Func>::result_type>
-    ParsecComponent<NewResult>
+    ParsecComponent<NewResult, Input>
     operator>>(Func &&callback) const
     {
-        return ParsecComponent<NewResult>(
-            [exec = exec_, cb = std::move(callback)]
-            (const std::string &str, std::size_t &index)
+        return ParsecComponent<NewResult, Input>(
+            [node = node_, cb = std::move(callback)]
+            (const Input &str, std::size_t &index)
             {
-                return callback_template<NewResult>(exec, cb, str, index);
+                return callback_template<NewResult>(node->exec, cb, str, index);
+            },
+            [node = node_]
+            (const Input &str, std::size_t &index)
+            {
+                return node->recognize(str, index);
             });
     }
 
     template<typename RhsResult,
         typename NewResult = addition_t<Result, RhsResult>>
-    ParsecComponent<NewResult>
-    operator|(const ParsecComponent<RhsResult> &rhs) const
+    ParsecComponent<NewResult, Input>
+    operator|(const ParsecComponent<RhsResult, Input> &rhs) const
     {
-        return ParsecComponent<NewResult>(
-            [lexec = exec_, rexec = rhs.exec()]
-            (const std::string &str, std::size_t &index)
+        return ParsecComponent<NewResult, Input>(
+            [lnode = node_, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
             {
-                return alternate_template<NewResult>(lexec, rexec, str, index);
+                return alternate_template<NewResult>(lnode->exec, rnode->exec, str, index);
+            },
+            [lnode = node_, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
+            {
+                return alternate_recognize(*lnode, *rnode, str, index);
             });
     }
 
     template<typename RhsResult,
         typename NewResult = product_t<Result, RhsResult>>
-    ParsecComponent<NewResult>
-    operator+(const ParsecComponent<RhsResult> &rhs) const
+    ParsecComponent<NewResult, Input>
+    operator+(const ParsecComponent<RhsResult, Input> &rhs) const
     {
-        return ParsecComponent<NewResult>(
-            [lexec = exec_, rexec = rhs.exec()]
-            (const std::string &str, std::size_t &index)
+        return ParsecComponent<NewResult, Input>(
+            [lnode = node_, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
             {
-                return connect_template<NewResult>(lexec, rexec, str, index);
+                return connect_template<NewResult>(lnode->exec, rnode->exec, str, index);
+            },
+            [lnode = node_, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
+            {
+                return connect_recognize(*lnode, *rnode, str, index);
             });
     }
 
     template<typename RhsResult>
-    ParsecComponent<addition_t<Result, RhsResult>>
-    operator|(const Parsec<RhsResult> &rhs) const;
+    ParsecComponent<addition_t<Result, RhsResult>, Input>
+    operator|(const Parsec<RhsResult, Input> &rhs) const;
 
     template<typename RhsResult>
-    ParsecComponent<product_t<Result, RhsResult>>
-    operator+(const Parsec<RhsResult> &rhs) const;
+    ParsecComponent<product_t<Result, RhsResult>, Input>
+    operator+(const Parsec<RhsResult, Input> &rhs) const;
 
     auto &exec() const
     {
-        return exec_;
+        return node_->exec;
+    }
+
+    auto &node() const
+    {
+        return node_;
     }
 
   private:
-    std::function<OptResult(const std::string &, std::size_t &)> exec_;
+    std::shared_ptr<const Node> node_;
 };
 
-template<typename Result>
+template<typename Result, typename Input>
 class Parsec final
 {
   public:
     Parsec() : component_(nullptr) {};
-    Parsec(ParsecComponent<Result> &&component)
-      : component_(std::make_shared<ParsecComponent<Result>(std::move(component))>) {}
+    Parsec(ParsecComponent<Result, Input> &&component)
+      : component_(std::make_shared<ParsecComponent<Result, Input>>(std::move(component))) {}
 
-    auto component() const
+    auto &component() const
     {
         return component_;
     }
 
     template<typename RecvResult>
     Parsec
-    &operator=(ParsecComponent<RecvResult> &&component)
+    &operator=(ParsecComponent<RecvResult, Input> &&component)
     {
         if constexpr (std::is_same_v<RecvResult, Result>)
         {
-            component_ = std::make_shared<ParsecComponent<Result>>(std::move(component));
+            component_ = std::make_shared<ParsecComponent<Result, Input>>(std::move(component));
         }
         else
         {
             static_assert(std::is_convertible_v<RecvResult, Result>);
-            component_ = std::make_shared<ParsecComponent<Result>>(
-                [exec = component.exec()]
-                (const std::string &str, std::size_t &index)
+            component_ = std::make_shared<ParsecComponent<Result, Input>>(
+                [node = component.node()]
+                (const Input &str, std::size_t &index)
                     -> std::optional<Result>
                 {
-                    return exec(str, index);
+                    return node->exec(str, index);
+                },
+                [node = component.node()]
+                (const Input &str, std::size_t &index)
+                {
+                    return node->recognize(str, index);
                 });
         }
         return *this;
@@ -439,28 +634,33 @@ class Parsec final
 
     template<typename RecvResult>
     Parsec
-    &operator=(const Parsec<RecvResult> &recv)
+    &operator=(const Parsec<RecvResult, Input> &recv)
     {
         static_assert(std::is_convertible_v<RecvResult, Result>);
-        component_ = std::make_shared<ParsecComponent<Result>>(
+        component_ = std::make_shared<ParsecComponent<Result, Input>>(
             [&recv]
-            (const std::string &str, std::size_t &index)
+            (const Input &str, std::size_t &index)
                 -> std::optional<Result>
             {
                 return recv.component()->operator()(str, index);
+            },
+            [&recv]
+            (const Input &str, std::size_t &index)
+            {
+                return recv.component()->recognize(str, index);
             });
         return *this;
     }
 
     Result
-    operator()(const std::string &str) const
+    operator()(const Input &str) const
     {
         std::size_t index = 0;
         return operator()(str, index);
     }
 
     Result
-    operator()(const std::string &str, std::size_t &index) const
+    operator()(const Input &str, std::size_t &index) const
     {
         if (component_)
         {
@@ -480,114 +680,256 @@ class Parsec final
         }
     }
 
+    // Checks if str is well-formed without running any action. Values
+    // that drive later parsing still need exec, see deferred
+    bool
+    recognize(const Input &str) const
+    {
+        std::size_t index = 0;
+        return recognize(str, index);
+    }
+
+    bool
+    recognize(const Input &str, std::size_t &index) const
+    {
+        if (component_)
+        {
+            return component_->recognize(str, index);
+        }
+        else
+        {
+            throw std::runtime_error("not give definition");
+        }
+    }
+
+    // Recognizes str first while tracing the failed alternatives, then
+    // runs the actions once, only along the successful derivation.
+    //
+    // Some values drive later parsing: the counts of count, the lengths
+    // of Bytes::blob, the inputs of chain and the results of two-argument
+    // Token::epsilon parsers. They are parsed by exec while recognizing,
+    // then reused by the replay, so their actions also run exactly once.
+    Result
+    deferred(const Input &str) const
+    {
+        std::size_t index = 0;
+        return deferred(str, index);
+    }
+
+    Result
+    deferred(const Input &str, std::size_t &index) const
+    {
+        Trace trace;
+        TraceGuard guard(&trace);
+
+        auto anchor = index;
+        if (!recognize(str, index))
+        {
+            throw std::runtime_error("parse error at " + std::to_string(index));
+        }
+        index = anchor;
+        theReplaying = true;
+        return operator()(str, index);
+    }
+
     template<typename Func,
         typename NewResult = typename lambda_traits<Func>::result_type>
-    ParsecComponent<NewResult>
+    ParsecComponent<NewResult, Input>
     operator>>(Func &&callback)
     {
-        return ParsecComponent<NewResult>(
+        return ParsecComponent<NewResult, Input>(
             [this, cb = std::move(callback)]
-            (const std::string &str, std::size_t &index)
+            (const Input &str, std::size_t &index)
             {
                 return callback_template<NewResult>(
                     this->component()->exec(), cb, str, index);
+            },
+            [this]
+            (const Input &str, std::size_t &index)
+            {
+                return this->component()->recognize(str, index);
             });
     }
 
     template<typename RhsResult,
         typename NewResult = addition_t<Result, RhsResult>>
-    ParsecComponent<NewResult>
-    operator|(const Parsec<RhsResult> &rhs)
+    ParsecComponent<NewResult, Input>
+    operator|(const Parsec<RhsResult, Input> &rhs)
     {
-        return ParsecComponent<NewResult>(
+        return ParsecComponent<NewResult, Input>(
             [this, &rhs]
-            (const std::string &str, std::size_t &index)
+            (const Input &str, std::size_t &index)
             {
                 return alternate_template<NewResult>(
                     this->component()->exec(),
                     rhs.component()->exec(), str, index);
+            },
+            [this, &rhs]
+            (const Input &str, std::size_t &index)
+            {
+                return alternate_recognize(
+                    *this->component()->node(),
+                    *rhs.component()->node(), str, index);
             });
     }
 
     template<typename RhsResult,
         typename NewResult = product_t<Result, RhsResult>>
-    ParsecComponent<NewResult>
-    operator+(const Parsec<RhsResult> &rhs)
+    ParsecComponent<NewResult, Input>
+    operator+(const Parsec<RhsResult, Input> &rhs)
     {
-        return ParsecComponent<NewResult>(
+        return ParsecComponent<NewResult, Input>(
             [this, &rhs]
-            (const std::string &str, std::size_t &index)
+            (const Input &str, std::size_t &index)
             {
                 return connect_template<NewResult>(
                     this->component()->exec(),
                     rhs.component()->exec(), str, index);
+            },
+            [this, &rhs]
+            (const Input &str, std::size_t &index)
+            {
+                return connect_recognize(
+                    *this->component()->node(),
+                    *rhs.component()->node(), str, index);
             });
     }
 
     template<typename RhsResult,
         typename NewResult = addition_t<Result, RhsResult>>
-    ParsecComponent<NewResult>
-    operator|(const ParsecComponent<RhsResult> &rhs)
+    ParsecComponent<NewResult, Input>
+    operator|(const ParsecComponent<RhsResult, Input> &rhs)
     {
-        return ParsecComponent<NewResult>(
-            [this, rexec = rhs.exec()]
-            (const std::string &str, std::size_t &index)
+        return ParsecComponent<NewResult, Input>(
+            [this, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
             {
                 return alternate_template<NewResult>(
-                    this->component()->exec(), rexec, str, index);
+                    this->component()->exec(), rnode->exec, str, index);
+            },
+            [this, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
+            {
+                return alternate_recognize(
+                    *this->component()->node(), *rnode, str, index);
             });
     }
 
     template<typename RhsResult,
         typename NewResult = product_t<Result, RhsResult>>
-    ParsecComponent<NewResult>
-    operator+(const ParsecComponent<RhsResult> &rhs)
+    ParsecComponent<NewResult, Input>
+    operator+(const ParsecComponent<RhsResult, Input> &rhs)
     {
-        return ParsecComponent<NewResult>(
-            [this, rexec = rhs.exec()]
-            (const std::string &str, std::size_t &index)
+        return ParsecComponent<NewResult, Input>(
+            [this, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
             {
                 return connect_template<NewResult>(
-                    this->component()->exec(), rexec, str, index);
+                    this->component()->exec(), rnode->exec, str, index);
+            },
+            [this, rnode = rhs.node()]
+            (const Input &str, std::size_t &index)
+            {
+                return connect_recognize(
+                    *this->component()->node(), *rnode, str, index);
             });
     }
 
   private:
-    std::shared_ptr<ParsecComponent<Result>> component_;
+    std::shared_ptr<ParsecComponent<Result, Input>> component_;
 };
 
-template<typename Result>
+template<typename Result, typename Input>
 template<typename RhsResult>
 inline
-ParsecComponent<addition_t<Result, RhsResult>>
-ParsecComponent<Result>::operator|(const Parsec<RhsResult> &rhs) const
+ParsecComponent<addition_t<Result, RhsResult>, Input>
+ParsecComponent<Result, Input>::operator|(const Parsec<RhsResult, Input> &rhs) const
 {
     using NewResult = addition_t<Result, RhsResult>;
-    return ParsecComponent<NewResult>(
-        [lexec = exec_, &rhs]
-        (const std::string &str, std::size_t &index)
+    return ParsecComponent<NewResult, Input>(
+        [lnode = node_, &rhs]
+        (const Input &str, std::size_t &index)
         {
-            return alternate_template<NewResult>(lexec,
+            return alternate_template<NewResult>(lnode->exec,
                 rhs.component()->exec(), str, index);
+        },
+        [lnode = node_, &rhs]
+        (const Input &str, std::size_t &index)
+        {
+            return alternate_recognize(*lnode,
+                *rhs.component()->node(), str, index);
         });
 }
 
-template<typename Result>
+template<typename Result, typename Input>
 template<typename RhsResult>
 inline
-ParsecComponent<product_t<Result, RhsResult>>
-ParsecComponent<Result>::operator+(const Parsec<RhsResult> &rhs) const
+ParsecComponent<product_t<Result, RhsResult>, Input>
+ParsecComponent<Result, Input>::operator+(const Parsec<RhsResult, Input> &rhs) const
 {
     using NewResult = product_t<Result, RhsResult>;
-    return ParsecComponent<NewResult>(
-        [lexec = exec_, &rhs]
-        (const std::string &str, std::size_t &index)
+    return ParsecComponent<NewResult, Input>(
+        [lnode = node_, &rhs]
+        (const Input &str, std::size_t &index)
         {
-            return connect_template<NewResult>(lexec,
+            return connect_template<NewResult>(lnode->exec,
                 rhs.component()->exec(), str, index);
+        },
+        [lnode = node_, &rhs]
+        (const Input &str, std::size_t &index)
+        {
+            return connect_recognize(*lnode,
+                *rhs.component()->node(), str, index);
         });
 }
 
+template<typename Kind>
+struct Lexed
+{
+    Kind kind;
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+// Output of a Lexer, parsers over it step through tokens instead of chars
+template<typename Kind>
+class TokenStream
+{
+  public:
+    TokenStream(std::string source)
+      : source_(std::move(source)) {}
+
+    std::size_t size() const
+    {
+        return tokens_.size();
+    }
+
+    const Lexed<Kind> &operator[](std::size_t index) const
+    {
+        return tokens_[index];
+    }
+
+    std::string_view text(std::size_t index) const
+    {
+        return std::string_view(source_).substr(
+            tokens_[index].offset, tokens_[index].length);
+    }
+
+    auto &source() const
+    {
+        return source_;
+    }
+
+    void push_back(const Lexed<Kind> &token)
+    {
+        tokens_.push_back(token);
+    }
+
+  private:
+    std::string source_;
+    std::vector<Lexed<Kind>> tokens_;
+};
+
 struct Token
 {
     static
@@ -610,53 +952,82 @@ struct Token
             });
     }
 
-    template<typename R>
+    template<typename R, typename Input = std::string>
     static
-    ParsecComponent<R>
+    ParsecComponent<R, Input>
     epsilon()
     {
-        return ParsecComponent<R>([]
-            (const std::string &str, std::size_t &index)
+        return ParsecComponent<R, Input>([]
+            (const Input &str, std::size_t &index)
                 -> std::optional<R>
             {
                 return R();
             });
     }
 
-    template<typename Func,
+    // Input is only used by the zero-argument form, the other one
+    // takes it from the type of its first argument
+    template<typename Input = std::string, typename Func,
         typename R = typename lambda_traits<Func>::result_type>
     static
-    ParsecComponent<R>
+    auto
     epsilon(Func &&func)
     {
         if constexpr (lambda_traits<Func>::arity == 0)
         {
-            return ParsecComponent<R>(
+            return ParsecComponent<R, Input>(
                 [f = std::move(func)]
-                (const std::string &str, std::size_t &index)
+                (const Input &str, std::size_t &index)
                     -> std::optional<R>
                 {
                     return f();
+                },
+                []
+                (const Input &str, std::size_t &index)
+                {
+                    return true;
                 });
         }
-        else if constexpr (lambda_traits<Func>::arity == 2
-            and std::is_same_v<lambda_traits<Func>::template arg_type_at<0>,
-                const std::string &>
-            and std::is_same_v<lambda_traits<Func>::template arg_type_at<1>,
-                std::size_t &>)
+        else
         {
-            return ParsecComponent<R>(
+            using ArgInput = std::decay_t<
+                typename lambda_traits<Func>::template arg_type_at<0>>;
+            static_assert(lambda_traits<Func>::arity == 2
+                and std::is_same_v<typename lambda_traits<Func>::template arg_type_at<0>,
+                    const ArgInput &>
+                and std::is_same_v<typename lambda_traits<Func>::template arg_type_at<1>,
+                    std::size_t &>);
+            return ParsecComponent<R, ArgInput>(
                 [f = std::move(func)]
-                (const std::string &str, std::size_t &index)
+                (const ArgInput &str, std::size_t &index)
                     -> std::optional<R>
                 {
-                    return f(str, index);
+                    return traced_value(&f, f, str, index);
                 });
         }
-        else
-        {
-            return;
-        }
+    }
+
+    // Matches one token of the given kind in a TokenStream, gives its text
+    template<typename Kind,
+        typename = std::enable_if_t<std::is_enum_v<Kind> or std::is_integral_v<Kind>>>
+    static
+    ParsecComponent<std::string_view, TokenStream<Kind>>
+    by(Kind kind)
+    {
+        return ParsecComponent<std::string_view, TokenStream<Kind>>(
+            [kind]
+            (const TokenStream<Kind> &str, std::size_t &index)
+                -> std::optional<std::string_view>
+            {
+                if (index < str.size() && str[index].kind == kind)
+                {
+                    return str.text(index++);
+                }
+                else
+                {
+                    return {};
+                }
+            });
     }
 };
 
@@ -702,6 +1073,1359 @@ operator""_T(const char *str, std::size_t len)
                 }
             }
             return pattern;
+        },
+        [pattern = std::string(str)]
+        (const std::string &str, std::size_t &index)
+        {
+            if (str.compare(index, pattern.size(), pattern) == 0)
+            {
+                index += pattern.size();
+                return true;
+            }
+            else
+            {
+                return false;
+            }
         });
 }
+
+template<typename R, typename Input>
+inline std::optional<std::vector<R>>
+count_template(std::size_t n, const std::function<std::optional<R>(const Input &, std::size_t &)> &exec,
+    const Input &str, std::size_t &index)
+{
+    auto anchor = index;
+    std::vector<R> values;
+    values.reserve(std::min(n, str.size() - index));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        auto value = exec(str, index);
+        if (value)
+        {
+            values.push_back(std::move(value).value());
+        }
+        else
+        {
+            index = anchor;
+            return {};
+        }
+    }
+    return values;
+}
+
+template<typename Node, typename Input>
+inline bool
+count_recognize(std::size_t n, const Node &node,
+    const Input &str, std::size_t &index)
+{
+    auto anchor = index;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!node.recognize(str, index))
+        {
+            index = anchor;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Exactly n times
+template<typename R, typename Input>
+inline
+ParsecComponent<std::vector<R>, Input>
+count(std::size_t n, const ParsecComponent<R, Input> &parser)
+{
+    return ParsecComponent<std::vector<R>, Input>(
+        [n, node = parser.node()]
+        (const Input &str, std::size_t &index)
+        {
+            return count_template(n, node->exec, str, index);
+        },
+        [n, node = parser.node()]
+        (const Input &str, std::size_t &index)
+        {
+            return count_recognize(n, *node, str, index);
+        });
+}
+
+// As many times as the value given by the count parser, parsed just before
+template<typename N, typename R, typename Input>
+inline
+ParsecComponent<std::vector<R>, Input>
+count(const ParsecComponent<N, Input> &n, const ParsecComponent<R, Input> &parser)
+{
+    static_assert(std::is_integral_v<N>);
+    return ParsecComponent<std::vector<R>, Input>(
+        [nnode = n.node(), node = parser.node()]
+        (const Input &str, std::size_t &index)
+            -> std::optional<std::vector<R>>
+        {
+            auto anchor = index;
+            auto n = traced_value(nnode.get(), nnode->exec, str, index);
+            if (n && *n >= 0)
+            {
+                auto values = count_template(std::size_t(*n), node->exec, str, index);
+                if (values)
+                {
+                    return values;
+                }
+            }
+            index = anchor;
+            return {};
+        },
+        [nnode = n.node(), node = parser.node()]
+        (const Input &str, std::size_t &index)
+        {
+            auto anchor = index;
+            auto n = traced_value(nnode.get(), nnode->exec, str, index);
+            if (n && *n >= 0 && count_recognize(std::size_t(*n), *node, str, index))
+            {
+                return true;
+            }
+            index = anchor;
+            return false;
+        });
+}
+
+// Parses with parser, then with the parser that factory makes from its
+// result, e.g. a count parsed earlier with other fields in between
+template<typename T, typename Input, typename Factory,
+    typename Next = decltype(apply_value(std::declval<const Factory &>(), std::declval<T &>())),
+    typename NewResult = product_t<T, typename Next::OptResult::value_type>>
+inline
+ParsecComponent<NewResult, Input>
+chain(const ParsecComponent<T, Input> &parser, Factory factory)
+{
+    // Made once per position while deferred, so both passes see one node
+    auto next = [factory = std::make_shared<const Factory>(std::move(factory))]
+        (const T &value, const Input &str, std::size_t index)
+    {
+        return traced_value(factory.get(),
+            [&](const Input &, std::size_t &)
+            {
+                return apply_value(*factory, value);
+            }, str, index);
+    };
+
+    return ParsecComponent<NewResult, Input>(
+        [node = parser.node(), next]
+        (const Input &str, std::size_t &index)
+            -> std::optional<NewResult>
+        {
+            auto anchor = index;
+            auto value = traced_value(node.get(), node->exec, str, index);
+            if (value)
+            {
+                auto rest = next(*value, str, anchor)(str, index);
+                if (rest)
+                {
+                    return concat_values(std::move(value).value(), std::move(rest).value());
+                }
+            }
+            index = anchor;
+            return {};
+        },
+        [node = parser.node(), next]
+        (const Input &str, std::size_t &index)
+        {
+            auto anchor = index;
+            auto value = traced_value(node.get(), node->exec, str, index);
+            if (value && next(*value, str, anchor).recognize(str, index))
+            {
+                return true;
+            }
+            index = anchor;
+            return false;
+        });
+}
+
+enum class Endian
+{
+#if __cplusplus > 201703L
+    Little = static_cast<int>(std::endian::little),
+    Big = static_cast<int>(std::endian::big),
+    Native = static_cast<int>(std::endian::native),
+#else
+    Little = __ORDER_LITTLE_ENDIAN__,
+    Big = __ORDER_BIG_ENDIAN__,
+    Native = __BYTE_ORDER__,
+#endif
+};
+
+template<std::size_t Size>
+struct unsigned_of_size;
+template<>
+struct unsigned_of_size<1>
+{
+    using type = std::uint8_t;
+};
+template<>
+struct unsigned_of_size<2>
+{
+    using type = std::uint16_t;
+};
+template<>
+struct unsigned_of_size<4>
+{
+    using type = std::uint32_t;
+};
+template<>
+struct unsigned_of_size<8>
+{
+    using type = std::uint64_t;
+};
+template<std::size_t Size>
+using unsigned_of_size_t = typename unsigned_of_size<Size>::type;
+
+template<typename U>
+inline U
+byteswap(U value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    if constexpr (sizeof(U) == 2)
+    {
+        return __builtin_bswap16(value);
+    }
+    else if constexpr (sizeof(U) == 4)
+    {
+        return __builtin_bswap32(value);
+    }
+    else if constexpr (sizeof(U) == 8)
+    {
+        return __builtin_bswap64(value);
+    }
+#endif
+    U result = 0;
+    for (std::size_t i = 0; i < sizeof(U); ++i)
+    {
+        result = U(result << 8) | U(value & 0xff);
+        value >>= 8;
+    }
+    return result;
+}
+
+// One unaligned load of a whole value instead of a byte at a time
+template<typename T, Endian endian>
+inline T
+load(const char *data)
+{
+    using U = unsigned_of_size_t<sizeof(T)>;
+    U bits;
+    std::memcpy(&bits, data, sizeof(U));
+    if constexpr (sizeof(U) > 1 && endian != Endian::Native)
+    {
+        bits = byteswap(bits);
+    }
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    return value;
+}
+
+struct Bytes
+{
+    // Fixed-width integer or floating point
+    template<typename T, Endian endian>
+    static
+    ParsecComponent<T>
+    fixed()
+    {
+        static_assert(std::is_arithmetic_v<T>);
+        return ParsecComponent<T>(
+            []
+            (const std::string &str, std::size_t &index)
+                -> std::optional<T>
+            {
+                if (index + sizeof(T) <= str.size())
+                {
+                    auto value = load<T, endian>(str.data() + index);
+                    index += sizeof(T);
+                    return value;
+                }
+                else
+                {
+                    return {};
+                }
+            });
+    }
+
+    template<typename T>
+    static
+    ParsecComponent<T>
+    le()
+    {
+        return fixed<T, Endian::Little>();
+    }
+
+    template<typename T>
+    static
+    ParsecComponent<T>
+    be()
+    {
+        return fixed<T, Endian::Big>();
+    }
+
+    // LEB128, signed types are zigzag encoded, encodings too long for
+    // T or with payload bits beyond its width are rejected
+    template<typename T>
+    static
+    ParsecComponent<T>
+    varint()
+    {
+        static_assert(std::is_integral_v<T>);
+        return ParsecComponent<T>(
+            []
+            (const std::string &str, std::size_t &index)
+                -> std::optional<T>
+            {
+                using U = std::make_unsigned_t<T>;
+                constexpr std::size_t limit = (sizeof(U) * 8 + 6) / 7;
+                constexpr std::size_t rest = sizeof(U) * 8 - 7 * (limit - 1);
+
+                U value = 0;
+                for (std::size_t i = 0; i < limit && index + i < str.size(); ++i)
+                {
+                    auto byte = static_cast<unsigned char>(str[index + i]);
+                    if (i == limit - 1 && (byte & 0x7f) >> rest)
+                    {
+                        return {};
+                    }
+                    value |= U(byte & 0x7f) << (7 * i);
+                    if (!(byte & 0x80))
+                    {
+                        index += i + 1;
+                        if constexpr (std::is_signed_v<T>)
+                        {
+                            return T((value >> 1) ^ (U(0) - (value & 1)));
+                        }
+                        else
+                        {
+                            return value;
+                        }
+                    }
+                }
+                return {};
+            });
+    }
+
+    // Length-prefixed bytes, given as a view into the input without copying
+    template<typename N>
+    static
+    ParsecComponent<std::string_view>
+    blob(const ParsecComponent<N> &length)
+    {
+        static_assert(std::is_integral_v<N>);
+        return ParsecComponent<std::string_view>(
+            [length = length.node()]
+            (const std::string &str, std::size_t &index)
+                -> std::optional<std::string_view>
+            {
+                auto anchor = index;
+                auto n = traced_value(length.get(), length->exec, str, index);
+                if (n && *n >= 0 && std::size_t(*n) <= str.size() - index)
+                {
+                    auto span = std::string_view(str).substr(index, *n);
+                    index += *n;
+                    return span;
+                }
+                else
+                {
+                    index = anchor;
+                    return {};
+                }
+            });
+    }
+};
+
+// Unicode 14.0.0 tables, generated from the Unicode Character Database
+// Letters, general category L
+inline constexpr char32_t theLetterRanges[][2] =
+{
+    {0x41, 0x5A}, {0x61, 0x7A}, {0xAA, 0xAA}, {0xB5, 0xB5}, {0xBA, 0xBA},
+    {0xC0, 0xD6}, {0xD8, 0xF6}, {0xF8, 0x2C1}, {0x2C6, 0x2D1}, {0x2E0, 0x2E4},
+    {0x2EC, 0x2EC}, {0x2EE, 0x2EE}, {0x370, 0x374}, {0x376, 0x377},
+    {0x37A, 0x37D}, {0x37F, 0x37F}, {0x386, 0x386}, {0x388, 0x38A},
+    {0x38C, 0x38C}, {0x38E, 0x3A1}, {0x3A3, 0x3F5}, {0x3F7, 0x481},
+    {0x48A, 0x52F}, {0x531, 0x556}, {0x559, 0x559}, {0x560, 0x588},
+    {0x5D0, 0x5EA}, {0x5EF, 0x5F2}, {0x620, 0x64A}, {0x66E, 0x66F},
+    {0x671, 0x6D3}, {0x6D5, 0x6D5}, {0x6E5, 0x6E6}, {0x6EE, 0x6EF},
+    {0x6FA, 0x6FC}, {0x6FF, 0x6FF}, {0x710, 0x710}, {0x712, 0x72F},
+    {0x74D, 0x7A5}, {0x7B1, 0x7B1}, {0x7CA, 0x7EA}, {0x7F4, 0x7F5},
+    {0x7FA, 0x7FA}, {0x800, 0x815}, {0x81A, 0x81A}, {0x824, 0x824},
+    {0x828, 0x828}, {0x840, 0x858}, {0x860, 0x86A}, {0x870, 0x887},
+    {0x889, 0x88E}, {0x8A0, 0x8C9}, {0x904, 0x939}, {0x93D, 0x93D},
+    {0x950, 0x950}, {0x958, 0x961}, {0x971, 0x980}, {0x985, 0x98C},
+    {0x98F, 0x990}, {0x993, 0x9A8}, {0x9AA, 0x9B0}, {0x9B2, 0x9B2},
+    {0x9B6, 0x9B9}, {0x9BD, 0x9BD}, {0x9CE, 0x9CE}, {0x9DC, 0x9DD},
+    {0x9DF, 0x9E1}, {0x9F0, 0x9F1}, {0x9FC, 0x9FC}, {0xA05, 0xA0A},
+    {0xA0F, 0xA10}, {0xA13, 0xA28}, {0xA2A, 0xA30}, {0xA32, 0xA33},
+    {0xA35, 0xA36}, {0xA38, 0xA39}, {0xA59, 0xA5C}, {0xA5E, 0xA5E},
+    {0xA72, 0xA74}, {0xA85, 0xA8D}, {0xA8F, 0xA91}, {0xA93, 0xAA8},
+    {0xAAA, 0xAB0}, {0xAB2, 0xAB3}, {0xAB5, 0xAB9}, {0xABD, 0xABD},
+    {0xAD0, 0xAD0}, {0xAE0, 0xAE1}, {0xAF9, 0xAF9}, {0xB05, 0xB0C},
+    {0xB0F, 0xB10}, {0xB13, 0xB28}, {0xB2A, 0xB30}, {0xB32, 0xB33},
+    {0xB35, 0xB39}, {0xB3D, 0xB3D}, {0xB5C, 0xB5D}, {0xB5F, 0xB61},
+    {0xB71, 0xB71}, {0xB83, 0xB83}, {0xB85, 0xB8A}, {0xB8E, 0xB90},
+    {0xB92, 0xB95}, {0xB99, 0xB9A}, {0xB9C, 0xB9C}, {0xB9E, 0xB9F},
+    {0xBA3, 0xBA4}, {0xBA8, 0xBAA}, {0xBAE, 0xBB9}, {0xBD0, 0xBD0},
+    {0xC05, 0xC0C}, {0xC0E, 0xC10}, {0xC12, 0xC28}, {0xC2A, 0xC39},
+    {0xC3D, 0xC3D}, {0xC58, 0xC5A}, {0xC5D, 0xC5D}, {0xC60, 0xC61},
+    {0xC80, 0xC80}, {0xC85, 0xC8C}, {0xC8E, 0xC90}, {0xC92, 0xCA8},
+    {0xCAA, 0xCB3}, {0xCB5, 0xCB9}, {0xCBD, 0xCBD}, {0xCDD, 0xCDE},
+    {0xCE0, 0xCE1}, {0xCF1, 0xCF2}, {0xD04, 0xD0C}, {0xD0E, 0xD10},
+    {0xD12, 0xD3A}, {0xD3D, 0xD3D}, {0xD4E, 0xD4E}, {0xD54, 0xD56},
+    {0xD5F, 0xD61}, {0xD7A, 0xD7F}, {0xD85, 0xD96}, {0xD9A, 0xDB1},
+    {0xDB3, 0xDBB}, {0xDBD, 0xDBD}, {0xDC0, 0xDC6}, {0xE01, 0xE30},
+    {0xE32, 0xE33}, {0xE40, 0xE46}, {0xE81, 0xE82}, {0xE84, 0xE84},
+    {0xE86, 0xE8A}, {0xE8C, 0xEA3}, {0xEA5, 0xEA5}, {0xEA7, 0xEB0},
+    {0xEB2, 0xEB3}, {0xEBD, 0xEBD}, {0xEC0, 0xEC4}, {0xEC6, 0xEC6},
+    {0xEDC, 0xEDF}, {0xF00, 0xF00}, {0xF40, 0xF47}, {0xF49, 0xF6C},
+    {0xF88, 0xF8C}, {0x1000, 0x102A}, {0x103F, 0x103F}, {0x1050, 0x1055},
+    {0x105A, 0x105D}, {0x1061, 0x1061}, {0x1065, 0x1066}, {0x106E, 0x1070},
+    {0x1075, 0x1081}, {0x108E, 0x108E}, {0x10A0, 0x10C5}, {0x10C7, 0x10C7},
+    {0x10CD, 0x10CD}, {0x10D0, 0x10FA}, {0x10FC, 0x1248}, {0x124A, 0x124D},
+    {0x1250, 0x1256}, {0x1258, 0x1258}, {0x125A, 0x125D}, {0x1260, 0x1288},
+    {0x128A, 0x128D}, {0x1290, 0x12B0}, {0x12B2, 0x12B5}, {0x12B8, 0x12BE},
+    {0x12C0, 0x12C0}, {0x12C2, 0x12C5}, {0x12C8, 0x12D6}, {0x12D8, 0x1310},
+    {0x1312, 0x1315}, {0x1318, 0x135A}, {0x1380, 0x138F}, {0x13A0, 0x13F5},
+    {0x13F8, 0x13FD}, {0x1401, 0x166C}, {0x166F, 0x167F}, {0x1681, 0x169A},
+    {0x16A0, 0x16EA}, {0x16F1, 0x16F8}, {0x1700, 0x1711}, {0x171F, 0x1731},
+    {0x1740, 0x1751}, {0x1760, 0x176C}, {0x176E, 0x1770}, {0x1780, 0x17B3},
+    {0x17D7, 0x17D7}, {0x17DC, 0x17DC}, {0x1820, 0x1878}, {0x1880, 0x1884},
+    {0x1887, 0x18A8}, {0x18AA, 0x18AA}, {0x18B0, 0x18F5}, {0x1900, 0x191E},
+    {0x1950, 0x196D}, {0x1970, 0x1974}, {0x1980, 0x19AB}, {0x19B0, 0x19C9},
+    {0x1A00, 0x1A16}, {0x1A20, 0x1A54}, {0x1AA7, 0x1AA7}, {0x1B05, 0x1B33},
+    {0x1B45, 0x1B4C}, {0x1B83, 0x1BA0}, {0x1BAE, 0x1BAF}, {0x1BBA, 0x1BE5},
+    {0x1C00, 0x1C23}, {0x1C4D, 0x1C4F}, {0x1C5A, 0x1C7D}, {0x1C80, 0x1C88},
+    {0x1C90, 0x1CBA}, {0x1CBD, 0x1CBF}, {0x1CE9, 0x1CEC}, {0x1CEE, 0x1CF3},
+    {0x1CF5, 0x1CF6}, {0x1CFA, 0x1CFA}, {0x1D00, 0x1DBF}, {0x1E00, 0x1F15},
+    {0x1F18, 0x1F1D}, {0x1F20, 0x1F45}, {0x1F48, 0x1F4D}, {0x1F50, 0x1F57},
+    {0x1F59, 0x1F59}, {0x1F5B, 0x1F5B}, {0x1F5D, 0x1F5D}, {0x1F5F, 0x1F7D},
+    {0x1F80, 0x1FB4}, {0x1FB6, 0x1FBC}, {0x1FBE, 0x1FBE}, {0x1FC2, 0x1FC4},
+    {0x1FC6, 0x1FCC}, {0x1FD0, 0x1FD3}, {0x1FD6, 0x1FDB}, {0x1FE0, 0x1FEC},
+    {0x1FF2, 0x1FF4}, {0x1FF6, 0x1FFC}, {0x2071, 0x2071}, {0x207F, 0x207F},
+    {0x2090, 0x209C}, {0x2102, 0x2102}, {0x2107, 0x2107}, {0x210A, 0x2113},
+    {0x2115, 0x2115}, {0x2119, 0x211D}, {0x2124, 0x2124}, {0x2126, 0x2126},
+    {0x2128, 0x2128}, {0x212A, 0x212D}, {0x212F, 0x2139}, {0x213C, 0x213F},
+    {0x2145, 0x2149}, {0x214E, 0x214E}, {0x2183, 0x2184}, {0x2C00, 0x2CE4},
+    {0x2CEB, 0x2CEE}, {0x2CF2, 0x2CF3}, {0x2D00, 0x2D25}, {0x2D27, 0x2D27},
+    {0x2D2D, 0x2D2D}, {0x2D30, 0x2D67}, {0x2D6F, 0x2D6F}, {0x2D80, 0x2D96},
+    {0x2DA0, 0x2DA6}, {0x2DA8, 0x2DAE}, {0x2DB0, 0x2DB6}, {0x2DB8, 0x2DBE},
+    {0x2DC0, 0x2DC6}, {0x2DC8, 0x2DCE}, {0x2DD0, 0x2DD6}, {0x2DD8, 0x2DDE},
+    {0x2E2F, 0x2E2F}, {0x3005, 0x3006}, {0x3031, 0x3035}, {0x303B, 0x303C},
+    {0x3041, 0x3096}, {0x309D, 0x309F}, {0x30A1, 0x30FA}, {0x30FC, 0x30FF},
+    {0x3105, 0x312F}, {0x3131, 0x318E}, {0x31A0, 0x31BF}, {0x31F0, 0x31FF},
+    {0x3400, 0x4DBF}, {0x4E00, 0xA48C}, {0xA4D0, 0xA4FD}, {0xA500, 0xA60C},
+    {0xA610, 0xA61F}, {0xA62A, 0xA62B}, {0xA640, 0xA66E}, {0xA67F, 0xA69D},
+    {0xA6A0, 0xA6E5}, {0xA717, 0xA71F}, {0xA722, 0xA788}, {0xA78B, 0xA7CA},
+    {0xA7D0, 0xA7D1}, {0xA7D3, 0xA7D3}, {0xA7D5, 0xA7D9}, {0xA7F2, 0xA801},
+    {0xA803, 0xA805}, {0xA807, 0xA80A}, {0xA80C, 0xA822}, {0xA840, 0xA873},
+    {0xA882, 0xA8B3}, {0xA8F2, 0xA8F7}, {0xA8FB, 0xA8FB}, {0xA8FD, 0xA8FE},
+    {0xA90A, 0xA925}, {0xA930, 0xA946}, {0xA960, 0xA97C}, {0xA984, 0xA9B2},
+    {0xA9CF, 0xA9CF}, {0xA9E0, 0xA9E4}, {0xA9E6, 0xA9EF}, {0xA9FA, 0xA9FE},
+    {0xAA00, 0xAA28}, {0xAA40, 0xAA42}, {0xAA44, 0xAA4B}, {0xAA60, 0xAA76},
+    {0xAA7A, 0xAA7A}, {0xAA7E, 0xAAAF}, {0xAAB1, 0xAAB1}, {0xAAB5, 0xAAB6},
+    {0xAAB9, 0xAABD}, {0xAAC0, 0xAAC0}, {0xAAC2, 0xAAC2}, {0xAADB, 0xAADD},
+    {0xAAE0, 0xAAEA}, {0xAAF2, 0xAAF4}, {0xAB01, 0xAB06}, {0xAB09, 0xAB0E},
+    {0xAB11, 0xAB16}, {0xAB20, 0xAB26}, {0xAB28, 0xAB2E}, {0xAB30, 0xAB5A},
+    {0xAB5C, 0xAB69}, {0xAB70, 0xABE2}, {0xAC00, 0xD7A3}, {0xD7B0, 0xD7C6},
+    {0xD7CB, 0xD7FB}, {0xF900, 0xFA6D}, {0xFA70, 0xFAD9}, {0xFB00, 0xFB06},
+    {0xFB13, 0xFB17}, {0xFB1D, 0xFB1D}, {0xFB1F, 0xFB28}, {0xFB2A, 0xFB36},
+    {0xFB38, 0xFB3C}, {0xFB3E, 0xFB3E}, {0xFB40, 0xFB41}, {0xFB43, 0xFB44},
+    {0xFB46, 0xFBB1}, {0xFBD3, 0xFD3D}, {0xFD50, 0xFD8F}, {0xFD92, 0xFDC7},
+    {0xFDF0, 0xFDFB}, {0xFE70, 0xFE74}, {0xFE76, 0xFEFC}, {0xFF21, 0xFF3A},
+    {0xFF41, 0xFF5A}, {0xFF66, 0xFFBE}, {0xFFC2, 0xFFC7}, {0xFFCA, 0xFFCF},
+    {0xFFD2, 0xFFD7}, {0xFFDA, 0xFFDC}, {0x10000, 0x1000B}, {0x1000D, 0x10026},
+    {0x10028, 0x1003A}, {0x1003C, 0x1003D}, {0x1003F, 0x1004D},
+    {0x10050, 0x1005D}, {0x10080, 0x100FA}, {0x10280, 0x1029C},
+    {0x102A0, 0x102D0}, {0x10300, 0x1031F}, {0x1032D, 0x10340},
+    {0x10342, 0x10349}, {0x10350, 0x10375}, {0x10380, 0x1039D},
+    {0x103A0, 0x103C3}, {0x103C8, 0x103CF}, {0x10400, 0x1049D},
+    {0x104B0, 0x104D3}, {0x104D8, 0x104FB}, {0x10500, 0x10527},
+    {0x10530, 0x10563}, {0x10570, 0x1057A}, {0x1057C, 0x1058A},
+    {0x1058C, 0x10592}, {0x10594, 0x10595}, {0x10597, 0x105A1},
+    {0x105A3, 0x105B1}, {0x105B3, 0x105B9}, {0x105BB, 0x105BC},
+    {0x10600, 0x10736}, {0x10740, 0x10755}, {0x10760, 0x10767},
+    {0x10780, 0x10785}, {0x10787, 0x107B0}, {0x107B2, 0x107BA},
+    {0x10800, 0x10805}, {0x10808, 0x10808}, {0x1080A, 0x10835},
+    {0x10837, 0x10838}, {0x1083C, 0x1083C}, {0x1083F, 0x10855},
+    {0x10860, 0x10876}, {0x10880, 0x1089E}, {0x108E0, 0x108F2},
+    {0x108F4, 0x108F5}, {0x10900, 0x10915}, {0x10920, 0x10939},
+    {0x10980, 0x109B7}, {0x109BE, 0x109BF}, {0x10A00, 0x10A00},
+    {0x10A10, 0x10A13}, {0x10A15, 0x10A17}, {0x10A19, 0x10A35},
+    {0x10A60, 0x10A7C}, {0x10A80, 0x10A9C}, {0x10AC0, 0x10AC7},
+    {0x10AC9, 0x10AE4}, {0x10B00, 0x10B35}, {0x10B40, 0x10B55},
+    {0x10B60, 0x10B72}, {0x10B80, 0x10B91}, {0x10C00, 0x10C48},
+    {0x10C80, 0x10CB2}, {0x10CC0, 0x10CF2}, {0x10D00, 0x10D23},
+    {0x10E80, 0x10EA9}, {0x10EB0, 0x10EB1}, {0x10F00, 0x10F1C},
+    {0x10F27, 0x10F27}, {0x10F30, 0x10F45}, {0x10F70, 0x10F81},
+    {0x10FB0, 0x10FC4}, {0x10FE0, 0x10FF6}, {0x11003, 0x11037},
+    {0x11071, 0x11072}, {0x11075, 0x11075}, {0x11083, 0x110AF},
+    {0x110D0, 0x110E8}, {0x11103, 0x11126}, {0x11144, 0x11144},
+    {0x11147, 0x11147}, {0x11150, 0x11172}, {0x11176, 0x11176},
+    {0x11183, 0x111B2}, {0x111C1, 0x111C4}, {0x111DA, 0x111DA},
+    {0x111DC, 0x111DC}, {0x11200, 0x11211}, {0x11213, 0x1122B},
+    {0x11280, 0x11286}, {0x11288, 0x11288}, {0x1128A, 0x1128D},
+    {0x1128F, 0x1129D}, {0x1129F, 0x112A8}, {0x112B0, 0x112DE},
+    {0x11305, 0x1130C}, {0x1130F, 0x11310}, {0x11313, 0x11328},
+    {0x1132A, 0x11330}, {0x11332, 0x11333}, {0x11335, 0x11339},
+    {0x1133D, 0x1133D}, {0x11350, 0x11350}, {0x1135D, 0x11361},
+    {0x11400, 0x11434}, {0x11447, 0x1144A}, {0x1145F, 0x11461},
+    {0x11480, 0x114AF}, {0x114C4, 0x114C5}, {0x114C7, 0x114C7},
+    {0x11580, 0x115AE}, {0x115D8, 0x115DB}, {0x11600, 0x1162F},
+    {0x11644, 0x11644}, {0x11680, 0x116AA}, {0x116B8, 0x116B8},
+    {0x11700, 0x1171A}, {0x11740, 0x11746}, {0x11800, 0x1182B},
+    {0x118A0, 0x118DF}, {0x118FF, 0x11906}, {0x11909, 0x11909},
+    {0x1190C, 0x11913}, {0x11915, 0x11916}, {0x11918, 0x1192F},
+    {0x1193F, 0x1193F}, {0x11941, 0x11941}, {0x119A0, 0x119A7},
+    {0x119AA, 0x119D0}, {0x119E1, 0x119E1}, {0x119E3, 0x119E3},
+    {0x11A00, 0x11A00}, {0x11A0B, 0x11A32}, {0x11A3A, 0x11A3A},
+    {0x11A50, 0x11A50}, {0x11A5C, 0x11A89}, {0x11A9D, 0x11A9D},
+    {0x11AB0, 0x11AF8}, {0x11C00, 0x11C08}, {0x11C0A, 0x11C2E},
+    {0x11C40, 0x11C40}, {0x11C72, 0x11C8F}, {0x11D00, 0x11D06},
+    {0x11D08, 0x11D09}, {0x11D0B, 0x11D30}, {0x11D46, 0x11D46},
+    {0x11D60, 0x11D65}, {0x11D67, 0x11D68}, {0x11D6A, 0x11D89},
+    {0x11D98, 0x11D98}, {0x11EE0, 0x11EF2}, {0x11FB0, 0x11FB0},
+    {0x12000, 0x12399}, {0x12480, 0x12543}, {0x12F90, 0x12FF0},
+    {0x13000, 0x1342E}, {0x14400, 0x14646}, {0x16800, 0x16A38},
+    {0x16A40, 0x16A5E}, {0x16A70, 0x16ABE}, {0x16AD0, 0x16AED},
+    {0x16B00, 0x16B2F}, {0x16B40, 0x16B43}, {0x16B63, 0x16B77},
+    {0x16B7D, 0x16B8F}, {0x16E40, 0x16E7F}, {0x16F00, 0x16F4A},
+    {0x16F50, 0x16F50}, {0x16F93, 0x16F9F}, {0x16FE0, 0x16FE1},
+    {0x16FE3, 0x16FE3}, {0x17000, 0x187F7}, {0x18800, 0x18CD5},
+    {0x18D00, 0x18D08}, {0x1AFF0, 0x1AFF3}, {0x1AFF5, 0x1AFFB},
+    {0x1AFFD, 0x1AFFE}, {0x1B000, 0x1B122}, {0x1B150, 0x1B152},
+    {0x1B164, 0x1B167}, {0x1B170, 0x1B2FB}, {0x1BC00, 0x1BC6A},
+    {0x1BC70, 0x1BC7C}, {0x1BC80, 0x1BC88}, {0x1BC90, 0x1BC99},
+    {0x1D400, 0x1D454}, {0x1D456, 0x1D49C}, {0x1D49E, 0x1D49F},
+    {0x1D4A2, 0x1D4A2}, {0x1D4A5, 0x1D4A6}, {0x1D4A9, 0x1D4AC},
+    {0x1D4AE, 0x1D4B9}, {0x1D4BB, 0x1D4BB}, {0x1D4BD, 0x1D4C3},
+    {0x1D4C5, 0x1D505}, {0x1D507, 0x1D50A}, {0x1D50D, 0x1D514},
+    {0x1D516, 0x1D51C}, {0x1D51E, 0x1D539}, {0x1D53B, 0x1D53E},
+    {0x1D540, 0x1D544}, {0x1D546, 0x1D546}, {0x1D54A, 0x1D550},
+    {0x1D552, 0x1D6A5}, {0x1D6A8, 0x1D6C0}, {0x1D6C2, 0x1D6DA},
+    {0x1D6DC, 0x1D6FA}, {0x1D6FC, 0x1D714}, {0x1D716, 0x1D734},
+    {0x1D736, 0x1D74E}, {0x1D750, 0x1D76E}, {0x1D770, 0x1D788},
+    {0x1D78A, 0x1D7A8}, {0x1D7AA, 0x1D7C2}, {0x1D7C4, 0x1D7CB},
+    {0x1DF00, 0x1DF1E}, {0x1E100, 0x1E12C}, {0x1E137, 0x1E13D},
+    {0x1E14E, 0x1E14E}, {0x1E290, 0x1E2AD}, {0x1E2C0, 0x1E2EB},
+    {0x1E7E0, 0x1E7E6}, {0x1E7E8, 0x1E7EB}, {0x1E7ED, 0x1E7EE},
+    {0x1E7F0, 0x1E7FE}, {0x1E800, 0x1E8C4}, {0x1E900, 0x1E943},
+    {0x1E94B, 0x1E94B}, {0x1EE00, 0x1EE03}, {0x1EE05, 0x1EE1F},
+    {0x1EE21, 0x1EE22}, {0x1EE24, 0x1EE24}, {0x1EE27, 0x1EE27},
+    {0x1EE29, 0x1EE32}, {0x1EE34, 0x1EE37}, {0x1EE39, 0x1EE39},
+    {0x1EE3B, 0x1EE3B}, {0x1EE42, 0x1EE42}, {0x1EE47, 0x1EE47},
+    {0x1EE49, 0x1EE49}, {0x1EE4B, 0x1EE4B}, {0x1EE4D, 0x1EE4F},
+    {0x1EE51, 0x1EE52}, {0x1EE54, 0x1EE54}, {0x1EE57, 0x1EE57},
+    {0x1EE59, 0x1EE59}, {0x1EE5B, 0x1EE5B}, {0x1EE5D, 0x1EE5D},
+    {0x1EE5F, 0x1EE5F}, {0x1EE61, 0x1EE62}, {0x1EE64, 0x1EE64},
+    {0x1EE67, 0x1EE6A}, {0x1EE6C, 0x1EE72}, {0x1EE74, 0x1EE77},
+    {0x1EE79, 0x1EE7C}, {0x1EE7E, 0x1EE7E}, {0x1EE80, 0x1EE89},
+    {0x1EE8B, 0x1EE9B}, {0x1EEA1, 0x1EEA3}, {0x1EEA5, 0x1EEA9},
+    {0x1EEAB, 0x1EEBB}, {0x20000, 0x2A6DF}, {0x2A700, 0x2B738},
+    {0x2B740, 0x2B81D}, {0x2B820, 0x2CEA1}, {0x2CEB0, 0x2EBE0},
+    {0x2F800, 0x2FA1D}, {0x30000, 0x3134A},
+};
+
+// Marks, general category M
+inline constexpr char32_t theMarkRanges[][2] =
+{
+    {0x300, 0x36F}, {0x483, 0x489}, {0x591, 0x5BD}, {0x5BF, 0x5BF},
+    {0x5C1, 0x5C2}, {0x5C4, 0x5C5}, {0x5C7, 0x5C7}, {0x610, 0x61A},
+    {0x64B, 0x65F}, {0x670, 0x670}, {0x6D6, 0x6DC}, {0x6DF, 0x6E4},
+    {0x6E7, 0x6E8}, {0x6EA, 0x6ED}, {0x711, 0x711}, {0x730, 0x74A},
+    {0x7A6, 0x7B0}, {0x7EB, 0x7F3}, {0x7FD, 0x7FD}, {0x816, 0x819},
+    {0x81B, 0x823}, {0x825, 0x827}, {0x829, 0x82D}, {0x859, 0x85B},
+    {0x898, 0x89F}, {0x8CA, 0x8E1}, {0x8E3, 0x903}, {0x93A, 0x93C},
+    {0x93E, 0x94F}, {0x951, 0x957}, {0x962, 0x963}, {0x981, 0x983},
+    {0x9BC, 0x9BC}, {0x9BE, 0x9C4}, {0x9C7, 0x9C8}, {0x9CB, 0x9CD},
+    {0x9D7, 0x9D7}, {0x9E2, 0x9E3}, {0x9FE, 0x9FE}, {0xA01, 0xA03},
+    {0xA3C, 0xA3C}, {0xA3E, 0xA42}, {0xA47, 0xA48}, {0xA4B, 0xA4D},
+    {0xA51, 0xA51}, {0xA70, 0xA71}, {0xA75, 0xA75}, {0xA81, 0xA83},
+    {0xABC, 0xABC}, {0xABE, 0xAC5}, {0xAC7, 0xAC9}, {0xACB, 0xACD},
+    {0xAE2, 0xAE3}, {0xAFA, 0xAFF}, {0xB01, 0xB03}, {0xB3C, 0xB3C},
+    {0xB3E, 0xB44}, {0xB47, 0xB48}, {0xB4B, 0xB4D}, {0xB55, 0xB57},
+    {0xB62, 0xB63}, {0xB82, 0xB82}, {0xBBE, 0xBC2}, {0xBC6, 0xBC8},
+    {0xBCA, 0xBCD}, {0xBD7, 0xBD7}, {0xC00, 0xC04}, {0xC3C, 0xC3C},
+    {0xC3E, 0xC44}, {0xC46, 0xC48}, {0xC4A, 0xC4D}, {0xC55, 0xC56},
+    {0xC62, 0xC63}, {0xC81, 0xC83}, {0xCBC, 0xCBC}, {0xCBE, 0xCC4},
+    {0xCC6, 0xCC8}, {0xCCA, 0xCCD}, {0xCD5, 0xCD6}, {0xCE2, 0xCE3},
+    {0xD00, 0xD03}, {0xD3B, 0xD3C}, {0xD3E, 0xD44}, {0xD46, 0xD48},
+    {0xD4A, 0xD4D}, {0xD57, 0xD57}, {0xD62, 0xD63}, {0xD81, 0xD83},
+    {0xDCA, 0xDCA}, {0xDCF, 0xDD4}, {0xDD6, 0xDD6}, {0xDD8, 0xDDF},
+    {0xDF2, 0xDF3}, {0xE31, 0xE31}, {0xE34, 0xE3A}, {0xE47, 0xE4E},
+    {0xEB1, 0xEB1}, {0xEB4, 0xEBC}, {0xEC8, 0xECD}, {0xF18, 0xF19},
+    {0xF35, 0xF35}, {0xF37, 0xF37}, {0xF39, 0xF39}, {0xF3E, 0xF3F},
+    {0xF71, 0xF84}, {0xF86, 0xF87}, {0xF8D, 0xF97}, {0xF99, 0xFBC},
+    {0xFC6, 0xFC6}, {0x102B, 0x103E}, {0x1056, 0x1059}, {0x105E, 0x1060},
+    {0x1062, 0x1064}, {0x1067, 0x106D}, {0x1071, 0x1074}, {0x1082, 0x108D},
+    {0x108F, 0x108F}, {0x109A, 0x109D}, {0x135D, 0x135F}, {0x1712, 0x1715},
+    {0x1732, 0x1734}, {0x1752, 0x1753}, {0x1772, 0x1773}, {0x17B4, 0x17D3},
+    {0x17DD, 0x17DD}, {0x180B, 0x180D}, {0x180F, 0x180F}, {0x1885, 0x1886},
+    {0x18A9, 0x18A9}, {0x1920, 0x192B}, {0x1930, 0x193B}, {0x1A17, 0x1A1B},
+    {0x1A55, 0x1A5E}, {0x1A60, 0x1A7C}, {0x1A7F, 0x1A7F}, {0x1AB0, 0x1ACE},
+    {0x1B00, 0x1B04}, {0x1B34, 0x1B44}, {0x1B6B, 0x1B73}, {0x1B80, 0x1B82},
+    {0x1BA1, 0x1BAD}, {0x1BE6, 0x1BF3}, {0x1C24, 0x1C37}, {0x1CD0, 0x1CD2},
+    {0x1CD4, 0x1CE8}, {0x1CED, 0x1CED}, {0x1CF4, 0x1CF4}, {0x1CF7, 0x1CF9},
+    {0x1DC0, 0x1DFF}, {0x20D0, 0x20F0}, {0x2CEF, 0x2CF1}, {0x2D7F, 0x2D7F},
+    {0x2DE0, 0x2DFF}, {0x302A, 0x302F}, {0x3099, 0x309A}, {0xA66F, 0xA672},
+    {0xA674, 0xA67D}, {0xA69E, 0xA69F}, {0xA6F0, 0xA6F1}, {0xA802, 0xA802},
+    {0xA806, 0xA806}, {0xA80B, 0xA80B}, {0xA823, 0xA827}, {0xA82C, 0xA82C},
+    {0xA880, 0xA881}, {0xA8B4, 0xA8C5}, {0xA8E0, 0xA8F1}, {0xA8FF, 0xA8FF},
+    {0xA926, 0xA92D}, {0xA947, 0xA953}, {0xA980, 0xA983}, {0xA9B3, 0xA9C0},
+    {0xA9E5, 0xA9E5}, {0xAA29, 0xAA36}, {0xAA43, 0xAA43}, {0xAA4C, 0xAA4D},
+    {0xAA7B, 0xAA7D}, {0xAAB0, 0xAAB0}, {0xAAB2, 0xAAB4}, {0xAAB7, 0xAAB8},
+    {0xAABE, 0xAABF}, {0xAAC1, 0xAAC1}, {0xAAEB, 0xAAEF}, {0xAAF5, 0xAAF6},
+    {0xABE3, 0xABEA}, {0xABEC, 0xABED}, {0xFB1E, 0xFB1E}, {0xFE00, 0xFE0F},
+    {0xFE20, 0xFE2F}, {0x101FD, 0x101FD}, {0x102E0, 0x102E0},
+    {0x10376, 0x1037A}, {0x10A01, 0x10A03}, {0x10A05, 0x10A06},
+    {0x10A0C, 0x10A0F}, {0x10A38, 0x10A3A}, {0x10A3F, 0x10A3F},
+    {0x10AE5, 0x10AE6}, {0x10D24, 0x10D27}, {0x10EAB, 0x10EAC},
+    {0x10F46, 0x10F50}, {0x10F82, 0x10F85}, {0x11000, 0x11002},
+    {0x11038, 0x11046}, {0x11070, 0x11070}, {0x11073, 0x11074},
+    {0x1107F, 0x11082}, {0x110B0, 0x110BA}, {0x110C2, 0x110C2},
+    {0x11100, 0x11102}, {0x11127, 0x11134}, {0x11145, 0x11146},
+    {0x11173, 0x11173}, {0x11180, 0x11182}, {0x111B3, 0x111C0},
+    {0x111C9, 0x111CC}, {0x111CE, 0x111CF}, {0x1122C, 0x11237},
+    {0x1123E, 0x1123E}, {0x112DF, 0x112EA}, {0x11300, 0x11303},
+    {0x1133B, 0x1133C}, {0x1133E, 0x11344}, {0x11347, 0x11348},
+    {0x1134B, 0x1134D}, {0x11357, 0x11357}, {0x11362, 0x11363},
+    {0x11366, 0x1136C}, {0x11370, 0x11374}, {0x11435, 0x11446},
+    {0x1145E, 0x1145E}, {0x114B0, 0x114C3}, {0x115AF, 0x115B5},
+    {0x115B8, 0x115C0}, {0x115DC, 0x115DD}, {0x11630, 0x11640},
+    {0x116AB, 0x116B7}, {0x1171D, 0x1172B}, {0x1182C, 0x1183A},
+    {0x11930, 0x11935}, {0x11937, 0x11938}, {0x1193B, 0x1193E},
+    {0x11940, 0x11940}, {0x11942, 0x11943}, {0x119D1, 0x119D7},
+    {0x119DA, 0x119E0}, {0x119E4, 0x119E4}, {0x11A01, 0x11A0A},
+    {0x11A33, 0x11A39}, {0x11A3B, 0x11A3E}, {0x11A47, 0x11A47},
+    {0x11A51, 0x11A5B}, {0x11A8A, 0x11A99}, {0x11C2F, 0x11C36},
+    {0x11C38, 0x11C3F}, {0x11C92, 0x11CA7}, {0x11CA9, 0x11CB6},
+    {0x11D31, 0x11D36}, {0x11D3A, 0x11D3A}, {0x11D3C, 0x11D3D},
+    {0x11D3F, 0x11D45}, {0x11D47, 0x11D47}, {0x11D8A, 0x11D8E},
+    {0x11D90, 0x11D91}, {0x11D93, 0x11D97}, {0x11EF3, 0x11EF6},
+    {0x16AF0, 0x16AF4}, {0x16B30, 0x16B36}, {0x16F4F, 0x16F4F},
+    {0x16F51, 0x16F87}, {0x16F8F, 0x16F92}, {0x16FE4, 0x16FE4},
+    {0x16FF0, 0x16FF1}, {0x1BC9D, 0x1BC9E}, {0x1CF00, 0x1CF2D},
+    {0x1CF30, 0x1CF46}, {0x1D165, 0x1D169}, {0x1D16D, 0x1D172},
+    {0x1D17B, 0x1D182}, {0x1D185, 0x1D18B}, {0x1D1AA, 0x1D1AD},
+    {0x1D242, 0x1D244}, {0x1DA00, 0x1DA36}, {0x1DA3B, 0x1DA6C},
+    {0x1DA75, 0x1DA75}, {0x1DA84, 0x1DA84}, {0x1DA9B, 0x1DA9F},
+    {0x1DAA1, 0x1DAAF}, {0x1E000, 0x1E006}, {0x1E008, 0x1E018},
+    {0x1E01B, 0x1E021}, {0x1E023, 0x1E024}, {0x1E026, 0x1E02A},
+    {0x1E130, 0x1E136}, {0x1E2AE, 0x1E2AE}, {0x1E2EC, 0x1E2EF},
+    {0x1E8D0, 0x1E8D6}, {0x1E944, 0x1E94A}, {0xE0100, 0xE01EF},
+};
+
+// Decimal digits, general category Nd
+inline constexpr char32_t theDigitRanges[][2] =
+{
+    {0x30, 0x39}, {0x660, 0x669}, {0x6F0, 0x6F9}, {0x7C0, 0x7C9},
+    {0x966, 0x96F}, {0x9E6, 0x9EF}, {0xA66, 0xA6F}, {0xAE6, 0xAEF},
+    {0xB66, 0xB6F}, {0xBE6, 0xBEF}, {0xC66, 0xC6F}, {0xCE6, 0xCEF},
+    {0xD66, 0xD6F}, {0xDE6, 0xDEF}, {0xE50, 0xE59}, {0xED0, 0xED9},
+    {0xF20, 0xF29}, {0x1040, 0x1049}, {0x1090, 0x1099}, {0x17E0, 0x17E9},
+    {0x1810, 0x1819}, {0x1946, 0x194F}, {0x19D0, 0x19D9}, {0x1A80, 0x1A89},
+    {0x1A90, 0x1A99}, {0x1B50, 0x1B59}, {0x1BB0, 0x1BB9}, {0x1C40, 0x1C49},
+    {0x1C50, 0x1C59}, {0xA620, 0xA629}, {0xA8D0, 0xA8D9}, {0xA900, 0xA909},
+    {0xA9D0, 0xA9D9}, {0xA9F0, 0xA9F9}, {0xAA50, 0xAA59}, {0xABF0, 0xABF9},
+    {0xFF10, 0xFF19}, {0x104A0, 0x104A9}, {0x10D30, 0x10D39},
+    {0x11066, 0x1106F}, {0x110F0, 0x110F9}, {0x11136, 0x1113F},
+    {0x111D0, 0x111D9}, {0x112F0, 0x112F9}, {0x11450, 0x11459},
+    {0x114D0, 0x114D9}, {0x11650, 0x11659}, {0x116C0, 0x116C9},
+    {0x11730, 0x11739}, {0x118E0, 0x118E9}, {0x11950, 0x11959},
+    {0x11C50, 0x11C59}, {0x11D50, 0x11D59}, {0x11DA0, 0x11DA9},
+    {0x16A60, 0x16A69}, {0x16AC0, 0x16AC9}, {0x16B50, 0x16B59},
+    {0x1D7CE, 0x1D7FF}, {0x1E140, 0x1E149}, {0x1E2F0, 0x1E2F9},
+    {0x1E950, 0x1E959}, {0x1FBF0, 0x1FBF9},
+};
+
+// Connector punctuations, general category Pc
+inline constexpr char32_t theConnectorRanges[][2] =
+{
+    {0x5F, 0x5F}, {0x203F, 0x2040}, {0x2054, 0x2054}, {0xFE33, 0xFE34},
+    {0xFE4D, 0xFE4F}, {0xFF3F, 0xFF3F},
+};
+
+// White_Space property
+inline constexpr char32_t theSpaceRanges[][2] =
+{
+    {0x9, 0xD}, {0x20, 0x20}, {0x85, 0x85}, {0xA0, 0xA0}, {0x1680, 0x1680},
+    {0x2000, 0x200A}, {0x2028, 0x2029}, {0x202F, 0x202F}, {0x205F, 0x205F},
+    {0x3000, 0x3000},
+};
+
+// Set of code points as sorted disjoint ranges, with a bitmap for ASCII
+class CodePoints
+{
+  public:
+    CodePoints() = default;
+
+    template<std::size_t N>
+    CodePoints(const char32_t (&ranges)[N][2])
+    {
+        for (auto &range : ranges)
+        {
+            ranges_.emplace_back(range[0], range[1]);
+        }
+        normalize();
+    }
+
+    static
+    CodePoints
+    range(char32_t first, char32_t last)
+    {
+        CodePoints points;
+        points.ranges_.emplace_back(first, last);
+        points.normalize();
+        return points;
+    }
+
+    static
+    CodePoints
+    of(char32_t code)
+    {
+        return range(code, code);
+    }
+
+    static
+    CodePoints
+    letter()
+    {
+        return CodePoints(theLetterRanges);
+    }
+
+    static
+    CodePoints
+    mark()
+    {
+        return CodePoints(theMarkRanges);
+    }
+
+    static
+    CodePoints
+    digit()
+    {
+        return CodePoints(theDigitRanges);
+    }
+
+    static
+    CodePoints
+    connector()
+    {
+        return CodePoints(theConnectorRanges);
+    }
+
+    static
+    CodePoints
+    space()
+    {
+        return CodePoints(theSpaceRanges);
+    }
+
+    CodePoints
+    operator|(const CodePoints &rhs) const
+    {
+        CodePoints points(*this);
+        points.ranges_.insert(points.ranges_.end(),
+            rhs.ranges_.begin(), rhs.ranges_.end());
+        points.normalize();
+        return points;
+    }
+
+    bool
+    contains(char32_t code) const
+    {
+        if (code < 128)
+        {
+            return ascii_[code];
+        }
+        auto it = std::upper_bound(ranges_.begin(), ranges_.end(),
+            std::make_pair(code, char32_t(0x10ffff)));
+        return it != ranges_.begin() && std::prev(it)->second >= code;
+    }
+
+  private:
+    std::bitset<128> ascii_;
+    std::vector<std::pair<char32_t, char32_t>> ranges_;
+
+    void
+    normalize()
+    {
+        std::sort(ranges_.begin(), ranges_.end());
+        std::vector<std::pair<char32_t, char32_t>> merged;
+        for (auto &range : ranges_)
+        {
+            if (!merged.empty() && range.first <= merged.back().second + 1)
+            {
+                merged.back().second = std::max(merged.back().second, range.second);
+            }
+            else
+            {
+                merged.push_back(range);
+            }
+        }
+        ranges_ = std::move(merged);
+
+        ascii_.reset();
+        for (auto &[first, last] : ranges_)
+        {
+            for (auto code = first; code <= last && code < 128; ++code)
+            {
+                ascii_[code] = true;
+            }
+        }
+    }
+};
+
+// Length of the well-formed UTF-8 sequence at data, or 0 if it is
+// truncated, overlong, a surrogate or beyond U+10FFFF
+inline int
+utf8_decode(const char *data, std::size_t size, char32_t &code)
+{
+    auto lead = static_cast<unsigned char>(data[0]);
+    if (lead < 0x80)
+    {
+        code = lead;
+        return 1;
+    }
+
+    int len;
+    char32_t least;
+    if ((lead & 0xe0) == 0xc0)
+    {
+        len = 2, code = lead & 0x1f, least = 0x80;
+    }
+    else if ((lead & 0xf0) == 0xe0)
+    {
+        len = 3, code = lead & 0x0f, least = 0x800;
+    }
+    else if ((lead & 0xf8) == 0xf0)
+    {
+        len = 4, code = lead & 0x07, least = 0x10000;
+    }
+    else
+    {
+        return 0;
+    }
+
+    if (size < std::size_t(len))
+    {
+        return 0;
+    }
+    for (int i = 1; i < len; ++i)
+    {
+        auto byte = static_cast<unsigned char>(data[i]);
+        if ((byte & 0xc0) != 0x80)
+        {
+            return 0;
+        }
+        code = (code << 6) | (byte & 0x3f);
+    }
+    if (code < least || code > 0x10ffff || (code >= 0xd800 && code <= 0xdfff))
+    {
+        return 0;
+    }
+    return len;
+}
+
+struct Utf8
+{
+    // Any well-formed code point
+    static
+    ParsecComponent<char32_t>
+    any()
+    {
+        return ParsecComponent<char32_t>(
+            []
+            (const std::string &str, std::size_t &index)
+                -> std::optional<char32_t>
+            {
+                char32_t code;
+                int len = index < str.size()
+                    ? utf8_decode(str.data() + index, str.size() - index, code) : 0;
+                if (len)
+                {
+                    index += len;
+                    return code;
+                }
+                else
+                {
+                    return {};
+                }
+            });
+    }
+
+    static
+    ParsecComponent<char32_t>
+    by(const CodePoints &points)
+    {
+        return ParsecComponent<char32_t>(
+            [points]
+            (const std::string &str, std::size_t &index)
+                -> std::optional<char32_t>
+            {
+                char32_t code;
+                int len = index < str.size()
+                    ? utf8_decode(str.data() + index, str.size() - index, code) : 0;
+                if (len && points.contains(code))
+                {
+                    index += len;
+                    return code;
+                }
+                else
+                {
+                    return {};
+                }
+            });
+    }
+
+    // Zero or more code points of the set, validated and classified in one
+    // pass, 8 bytes are checked at once and only decoded if a high bit is set
+    static
+    ParsecComponent<std::string_view>
+    many(const CodePoints &points)
+    {
+        return ParsecComponent<std::string_view>(
+            [points]
+            (const std::string &str, std::size_t &index)
+                -> std::optional<std::string_view>
+            {
+                auto end = span(points, str, index);
+                auto view = std::string_view(str).substr(index, end - index);
+                index = end;
+                return view;
+            });
+    }
+
+    // One or more code points of the set
+    static
+    ParsecComponent<std::string_view>
+    some(const CodePoints &points)
+    {
+        return ParsecComponent<std::string_view>(
+            [points]
+            (const std::string &str, std::size_t &index)
+                -> std::optional<std::string_view>
+            {
+                auto end = span(points, str, index);
+                if (end == index)
+                {
+                    return {};
+                }
+                auto view = std::string_view(str).substr(index, end - index);
+                index = end;
+                return view;
+            });
+    }
+
+    static
+    std::size_t
+    span(const CodePoints &points, const std::string &str, std::size_t index)
+    {
+        auto data = str.data();
+        auto size = str.size();
+        while (index < size)
+        {
+            while (index + 8 <= size)
+            {
+                std::uint64_t block;
+                std::memcpy(&block, data + index, 8);
+                if (block & 0x8080808080808080ull)
+                {
+                    break;
+                }
+                for (auto end = index + 8; index < end; ++index)
+                {
+                    if (!points.contains(static_cast<char32_t>(data[index])))
+                    {
+                        return index;
+                    }
+                }
+            }
+            if (index >= size)
+            {
+                break;
+            }
+
+            char32_t code;
+            int len = utf8_decode(data + index, size - index, code);
+            if (len && points.contains(code))
+            {
+                index += len;
+            }
+            else
+            {
+                return index;
+            }
+        }
+        return index;
+    }
+};
+
+struct NfaState
+{
+    std::bitset<256> chars;
+    int next = -1;
+    std::vector<int> epsilons;
+};
+
+// Table-driven DFA built by subset construction, each accepting state
+// is tagged with the smallest index of the NFA accepts it contains
+class Dfa
+{
+  public:
+    static constexpr int dead = -1;
+
+    Dfa(const std::vector<NfaState> &nfa, int start,
+        const std::vector<int> &accepts)
+    {
+        std::map<std::vector<int>, int> ids;
+        std::vector<std::vector<int>> sets;
+
+        auto closure = [&nfa](std::vector<int> set)
+        {
+            std::vector<bool> seen(nfa.size());
+            std::vector<int> stack(set);
+            set.clear();
+            while (!stack.empty())
+            {
+                auto n = stack.back();
+                stack.pop_back();
+                if (!seen[n])
+                {
+                    seen[n] = true;
+                    set.push_back(n);
+                    stack.insert(stack.end(),
+                        nfa[n].epsilons.begin(), nfa[n].epsilons.end());
+                }
+            }
+            std::sort(set.begin(), set.end());
+            return set;
+        };
+
+        auto add = [&](std::vector<int> set) -> int
+        {
+            if (set.empty())
+            {
+                return dead;
+            }
+            auto it = ids.find(set);
+            if (it != ids.end())
+            {
+                return it->second;
+            }
+
+            int id = sets.size();
+            int tag = dead;
+            for (std::size_t i = 0; i < accepts.size() && tag == dead; ++i)
+            {
+                if (std::binary_search(set.begin(), set.end(), accepts[i]))
+                {
+                    tag = i;
+                }
+            }
+            ids.emplace(set, id);
+            sets.push_back(std::move(set));
+            tags_.push_back(tag);
+            table_.resize(table_.size() + 256, dead);
+            return id;
+        };
+
+        add(closure({start}));
+        for (std::size_t state = 0; state < sets.size(); ++state)
+        {
+            auto set = sets[state];
+            for (int c = 0; c < 256; ++c)
+            {
+                std::vector<int> moved;
+                for (auto n : set)
+                {
+                    if (nfa[n].next >= 0 && nfa[n].chars[c])
+                    {
+                        moved.push_back(nfa[n].next);
+                    }
+                }
+                auto id = add(closure(std::move(moved)));
+                table_[state * 256 + c] = id;
+            }
+        }
+    }
+
+    // Longest match from index, returns the tag of it or dead
+    int
+    match(const std::string &str, std::size_t index, std::size_t &end) const
+    {
+        int state = 0;
+        int tag = tags_[0];
+        end = index;
+        for (auto i = index; i < str.size(); ++i)
+        {
+            state = table_[state * 256 + static_cast<unsigned char>(str[i])];
+            if (state == dead)
+            {
+                break;
+            }
+            if (tags_[state] != dead)
+            {
+                tag = tags_[state];
+                end = i + 1;
+            }
+        }
+        return tag;
+    }
+
+  private:
+    std::vector<int> table_;
+    std::vector<int> tags_;
+};
+
+// Regular sub-grammar without semantic actions, compiled to a Dfa
+// instead of a combinator tree, so matching costs one lookup per byte
+class Lexeme
+{
+  public:
+    // cond is called once for each byte value 0..255, which <cctype>
+    // predicates accept as they are
+    static
+    Lexeme
+    by(const std::function<bool(unsigned char)> &cond)
+    {
+        Lexeme lexeme;
+        lexeme.states_.resize(2);
+        for (int c = 0; c < 256; ++c)
+        {
+            lexeme.states_[0].chars[c] = cond(static_cast<unsigned char>(c));
+        }
+        lexeme.states_[0].next = 1;
+        lexeme.accept_ = 1;
+        return lexeme;
+    }
+
+    static
+    Lexeme
+    epsilon()
+    {
+        Lexeme lexeme;
+        lexeme.states_.resize(1);
+        return lexeme;
+    }
+
+    Lexeme
+    operator+(const Lexeme &rhs) const
+    {
+        Lexeme lexeme(*this);
+        auto offset = lexeme.append(rhs);
+        lexeme.states_[accept_].epsilons.push_back(rhs.start_ + offset);
+        lexeme.accept_ = rhs.accept_ + offset;
+        return lexeme;
+    }
+
+    Lexeme
+    operator|(const Lexeme &rhs) const
+    {
+        Lexeme lexeme;
+        lexeme.states_.resize(1);
+        auto loffset = lexeme.append(*this);
+        auto roffset = lexeme.append(rhs);
+        lexeme.accept_ = lexeme.states_.size();
+        lexeme.states_.emplace_back();
+        lexeme.states_[0].epsilons = {start_ + loffset, rhs.start_ + roffset};
+        lexeme.states_[accept_ + loffset].epsilons.push_back(lexeme.accept_);
+        lexeme.states_[rhs.accept_ + roffset].epsilons.push_back(lexeme.accept_);
+        return lexeme;
+    }
+
+    // Zero or more times
+    Lexeme
+    many() const
+    {
+        Lexeme lexeme;
+        lexeme.states_.resize(1);
+        auto offset = lexeme.append(*this);
+        lexeme.accept_ = lexeme.states_.size();
+        lexeme.states_.emplace_back();
+        lexeme.states_[0].epsilons = {start_ + offset, lexeme.accept_};
+        lexeme.states_[accept_ + offset].epsilons
+            = {start_ + offset, lexeme.accept_};
+        return lexeme;
+    }
+
+    // One or more times
+    Lexeme
+    some() const
+    {
+        return *this + many();
+    }
+
+    // Zero or one time
+    Lexeme
+    maybe() const
+    {
+        return *this | epsilon();
+    }
+
+    ParsecComponent<std::string_view>
+    compile() const
+    {
+        return ParsecComponent<std::string_view>(
+            [dfa = std::make_shared<const Dfa>(states_, start_,
+                std::vector<int>{accept_})]
+            (const std::string &str, std::size_t &index)
+                -> std::optional<std::string_view>
+            {
+                std::size_t end;
+                if (dfa->match(str, index, end) == Dfa::dead)
+                {
+                    return {};
+                }
+                else
+                {
+                    auto span = std::string_view(str).substr(index, end - index);
+                    index = end;
+                    return span;
+                }
+            });
+    }
+
+    auto &states() const
+    {
+        return states_;
+    }
+
+    int start() const
+    {
+        return start_;
+    }
+
+    int accept() const
+    {
+        return accept_;
+    }
+
+  private:
+    std::vector<NfaState> states_;
+    int start_ = 0;
+    int accept_ = 0;
+
+    int
+    append(const Lexeme &other)
+    {
+        int offset = states_.size();
+        for (auto state : other.states_)
+        {
+            if (state.next >= 0)
+            {
+                state.next += offset;
+            }
+            for (auto &n : state.epsilons)
+            {
+                n += offset;
+            }
+            states_.push_back(std::move(state));
+        }
+        return offset;
+    }
+};
+
+inline
+Lexeme
+operator""_L(char ch)
+{
+    return Lexeme::by([ch](unsigned char c) { return c == static_cast<unsigned char>(ch); });
+}
+
+inline
+Lexeme
+operator""_L(const char *str, std::size_t len)
+{
+    auto lexeme = Lexeme::epsilon();
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        lexeme = lexeme + operator""_L(str[i]);
+    }
+    return lexeme;
+}
+
+// Tokenizer stage, takes the longest match among its rules at each
+// position, the earlier rule wins if several match the same length
+template<typename Kind>
+class Lexer
+{
+  public:
+    using LexFunc = std::function<TokenStream<Kind>(std::string)>;
+
+    Lexer &rule(Kind kind, const Lexeme &lexeme)
+    {
+        rules_.emplace_back(kind, lexeme);
+        return *this;
+    }
+
+    // Matched but not put into the TokenStream, e.g. blanks and comments
+    Lexer &skip(const Lexeme &lexeme)
+    {
+        rules_.emplace_back(std::nullopt, lexeme);
+        return *this;
+    }
+
+    LexFunc
+    compile() const
+    {
+        std::vector<NfaState> states(1);
+        std::vector<int> accepts;
+        std::vector<std::optional<Kind>> kinds;
+        for (auto &[kind, lexeme] : rules_)
+        {
+            int offset = states.size();
+            states.insert(states.end(),
+                lexeme.states().begin(), lexeme.states().end());
+            for (auto i = std::size_t(offset); i < states.size(); ++i)
+            {
+                if (states[i].next >= 0)
+                {
+                    states[i].next += offset;
+                }
+                for (auto &n : states[i].epsilons)
+                {
+                    n += offset;
+                }
+            }
+            states[0].epsilons.push_back(lexeme.start() + offset);
+            accepts.push_back(lexeme.accept() + offset);
+            kinds.push_back(kind);
+        }
+
+        return [dfa = std::make_shared<const Dfa>(states, 0, accepts),
+            kinds = std::move(kinds)]
+            (std::string str)
+        {
+            if (str.size() > std::numeric_limits<std::uint32_t>::max())
+            {
+                throw std::runtime_error("input too large to lex");
+            }
+
+            TokenStream<Kind> tokens(std::move(str));
+            auto &source = tokens.source();
+            std::size_t index = 0, end;
+            while (index < source.size())
+            {
+                auto tag = dfa->match(source, index, end);
+                if (tag == Dfa::dead || end == index)
+                {
+                    throw std::runtime_error("lex error at " + std::to_string(index));
+                }
+                if (kinds[tag])
+                {
+                    tokens.push_back({*kinds[tag],
+                        static_cast<std::uint32_t>(index),
+                        static_cast<std::uint32_t>(end - index)});
+                }
+                index = end;
+            }
+            return tokens;
+        };
+    }
+
+  private:
+    std::vector<std::pair<std::optional<Kind>, Lexeme>> rules_;
+};
 }
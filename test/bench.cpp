@@ -0,0 +1,188 @@
+#include <new>
+#include <chrono>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include "../src/parsec.hpp"
+
+using namespace std;
+using namespace parsec;
+
+// Allocations are only counted while the startup benchmark builds its
+// grammar, so the other benchmarks pay for nothing but this branch
+bool counting = false;
+size_t allocations = 0, allocated = 0;
+
+void *operator new(size_t size)
+{
+    if (counting)
+    {
+        ++allocations;
+        allocated += size;
+    }
+    if (auto ptr = malloc(size ? size : 1))
+    {
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+// Kept out of line, or GCC flags the free() inlined into delete expressions
+[[gnu::noinline]] void operator delete(void *ptr) noexcept
+{
+    free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, size_t) noexcept
+{
+    free(ptr);
+}
+
+template<typename Func>
+void bench(const string &name, Func &&func)
+{
+    auto start = chrono::steady_clock::now();
+    auto checksum = func();
+    auto end = chrono::steady_clock::now();
+    cout << name << ": "
+         << chrono::duration<double, milli>(end - start).count() << " ms"
+         << " (checksum " << checksum << ")" << endl;
+}
+
+string lexemes(size_t count)
+{
+    string input;
+    for (size_t i = 0; i < count; ++i)
+    {
+        input += i % 2 ? "ident_" + to_string(i) : to_string(i * 7919);
+        input += i % 3 ? " " : "\n\t";
+    }
+    return input;
+}
+
+void bench_lexemes()
+{
+    auto input = lexemes(200000);
+
+    Parsec<char> Blanks;
+    Parsec<string> Digits, Rest;
+    Parsec<string> Number, Identifier;
+
+    // Combinator form
+    Blanks =
+      Token::by(::isspace) + Blanks >>
+        [](char, char) -> char
+        {
+            return 0;
+        } |
+      Token::epsilon<char>();
+    Digits =
+      Token::by(::isdigit) + Digits >>
+        [](char digit, string digits)
+        {
+            return digit + digits;
+        } |
+      Token::epsilon<string>();
+    Rest =
+      (Token::by(::isalnum) | '_'_T) + Rest >>
+        [](char ch, string rest)
+        {
+            return ch + rest;
+        } |
+      Token::epsilon<string>();
+    Number =
+      Token::by(::isdigit) + Digits >>
+        [](char digit, string digits)
+        {
+            return digit + digits;
+        };
+    Identifier =
+      (Token::by(::isalpha) | '_'_T) + Rest >>
+        [](char ch, string rest)
+        {
+            return ch + rest;
+        };
+    auto Word = Identifier | Number;
+
+    // Lexeme form
+    auto blanks = Lexeme::by(::isspace).many().compile();
+    auto word = (
+      (Lexeme::by(::isalpha) | '_'_L) + (Lexeme::by(::isalnum) | '_'_L).many() |
+      Lexeme::by(::isdigit).some()).compile();
+
+    bench("combinator lexemes", [&]
+    {
+        size_t index = 0, total = 0;
+        Blanks(input, index);
+        while (index < input.size())
+        {
+            total += Word(input, index).value().size();
+            Blanks(input, index);
+        }
+        return total;
+    });
+
+    bench("dfa lexemes", [&]
+    {
+        size_t index = 0, total = 0;
+        blanks(input, index);
+        while (index < input.size())
+        {
+            total += word(input, index).value().size();
+            blanks(input, index);
+        }
+        return total;
+    });
+}
+
+void bench_startup()
+{
+    allocations = allocated = 0;
+    counting = true;
+    auto start = chrono::steady_clock::now();
+
+    // Keywords shared by every rule
+    auto keyword = "kw0"_T;
+    for (size_t i = 1; i < 50; ++i)
+    {
+        auto name = "kw" + to_string(i);
+        keyword = keyword | operator""_T(name.c_str(), name.size());
+    }
+
+    // Rule_i
+    // : Rule_i-1 Keyword
+    // | Keyword
+    vector<ParsecComponent<string>> rules;
+    rules.push_back(keyword | Token::epsilon<string>());
+    for (size_t i = 1; i < 400; ++i)
+    {
+        rules.push_back(
+          rules.back() + keyword >>
+            [](string lhs, string rhs)
+            {
+                return lhs + rhs;
+            } |
+          keyword);
+    }
+
+    auto end = chrono::steady_clock::now();
+    counting = false;
+    cout << "startup with " << rules.size() << " rules: "
+         << chrono::duration<double, milli>(end - start).count() << " ms, "
+         << allocations << " allocations, "
+         << allocated / 1024 << " KiB allocated" << endl;
+
+    size_t index = 0;
+    string input = "kw1kw2kw49";
+    cout << "startup checksum " << rules.back()(input, index).value() << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    bench_lexemes();
+    bench_startup();
+
+    return 0;
+}
@@ -1,5 +1,7 @@
 #include <cctype>
 #include <string>
+#include <vector>
+#include <numeric>
 #include <iostream>
 #include "../src/parsec.hpp"
 
@@ -81,5 +83,122 @@ int main(int argc, char *argv[])
 
     cout << Additive("2 * 3 + 4 * 5") << endl;
 
+    // Actions run only along the successful derivation
+    cout << Additive.deferred("2 * 3 + 4 * 5") << endl;
+    // Only checks if it is well-formed, without running any action
+    cout << Additive.recognize("2 * 3 + 4 * 5") << endl;
+
+    // Identifier
+    // : [A-Za-z_] [A-Za-z0-9_]*
+    // compiled to a DFA as it is purely lexical
+    auto Identifier =
+      (Lexeme::by(::isalpha) | '_'_L) +
+      (Lexeme::by(::isalnum) | '_'_L).many();
+    auto identifier = Identifier.compile();
+
+    size_t index = 0;
+    cout << identifier("_foo42 + bar", index).value() << endl;
+
+    // Parsing over a token stream instead of chars
+    enum class Kind { Number, Plus };
+    auto lex = Lexer<Kind>()
+      .rule(Kind::Number, Lexeme::by(::isdigit).some())
+      .rule(Kind::Plus, '+'_L)
+      .skip(Lexeme::by(::isspace).some())
+      .compile();
+
+    // Sum
+    // : Number + Sum
+    // | Number
+    Parsec<int, TokenStream<Kind>> Sum;
+    Sum =
+      Token::by(Kind::Number) + Token::by(Kind::Plus) + Sum >>
+        [](string_view lhs, string_view, int rhs)
+        {
+            return stoi(string(lhs)) + rhs;
+        } |
+      Token::by(Kind::Number) >>
+        [](string_view number)
+        {
+            return stoi(string(number));
+        };
+
+    cout << Sum(lex("1 + 20 + 300")) << endl;
+
+    // Binary message
+    // : u16be(n) varint{n} u32le(len) byte{len}
+    auto Message =
+      count(Bytes::be<uint16_t>(), Bytes::varint<int>()) +
+      Bytes::blob(Bytes::le<uint32_t>()) >>
+        [](vector<int> values, string_view payload)
+        {
+            return accumulate(values.begin(), values.end(), 0)
+                + int(payload.size());
+        };
+
+    index = 0;
+    cout << Message(string("\x00\x03\x02\x03\xac\x02\x02\x00\x00\x00hi", 12),
+        index).value() << endl;
+
+    // Record
+    // : u16be(n) u8(flags) u8{n}
+    auto Record =
+      chain(Bytes::be<uint16_t>() + Bytes::le<uint8_t>(),
+        [](uint16_t n, uint8_t)
+        {
+            return count(n, Bytes::le<uint8_t>());
+        }) >>
+        [](uint16_t, uint8_t flags, vector<uint8_t> items)
+        {
+            return flags + accumulate(items.begin(), items.end(), 0);
+        };
+
+    index = 0;
+    cout << Record(string("\x00\x02\x10\x01\x02", 5), index).value() << endl;
+
+    // chain also runs through deferred, building its component once
+    Parsec<int> DeferredRecord;
+    DeferredRecord = move(Record);
+    cout << DeferredRecord.deferred(string("\x00\x02\x10\x01\x02", 5)) << endl;
+
+    // Nodes built by chain stay the same in both passes of deferred
+    Parsec<tuple<uint8_t, vector<char>>> Letters;
+    Letters =
+      chain(Bytes::le<uint8_t>(),
+        [](uint8_t n)
+        {
+            return count(n, 'a'_T) | count(n, 'b'_T);
+        }) |
+      chain(Bytes::le<uint8_t>(),
+        [](uint8_t n)
+        {
+            return count(n, 'c'_T) | count(n, 'd'_T);
+        });
+
+    cout << get<1>(Letters.deferred(string("\x02" "cc"))).size() << endl;
+
+    // Varints overflowing their type are rejected
+    index = 0;
+    cout << Bytes::varint<uint8_t>()(string("\xff\x7f"), index).has_value() << endl;
+
+    // Unicode identifier
+    // : (Letter | '_') (Letter | Mark | Digit | Connector)*
+    auto UnicodeIdentifier =
+      Utf8::by(CodePoints::letter() | CodePoints::of(U'_')) +
+      Utf8::many(CodePoints::letter() | CodePoints::mark()
+        | CodePoints::digit() | CodePoints::connector()) >>
+        [](char32_t, string_view rest)
+        {
+            return rest.size();
+        };
+
+    index = 0;
+    cout << UnicodeIdentifier("_naïve_變數1 = 2", index).value() << endl;
+
+    // Stops at the end even if the set includes U+0000
+    index = 0;
+    Utf8::many(CodePoints::range(0, 0x10ffff))("abcdefgh", index);
+    cout << index << endl;
+
     return 0;
 }